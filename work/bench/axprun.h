@@ -0,0 +1,134 @@
+//-----------------------------------------------------------------------------
+/*
+
+Host Runtime for Generated Patches
+
+Support code for the patch programs generated by axprun.py: the Axoloti
+buffer types, timing, the WAV writer for audio/out and the output checksum.
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef DEADSY_AXPRUN_H
+#define DEADSY_AXPRUN_H
+
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "shim.h"
+
+//-----------------------------------------------------------------------------
+
+typedef int32_t int32buffer[BUFSIZE];
+
+// unconnected inlets
+static const int32_t axp_zero_buf[BUFSIZE] = { 0 };
+
+static double axp_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// return the ns taken by an empty axp_now_ns() pair
+static double axp_timer_overhead(void) {
+	const int n = 100000;
+	double t0 = axp_now_ns();
+	for (int i = 0; i < n; i++) {
+		double t = axp_now_ns();
+		(void)t;
+	}
+	return (axp_now_ns() - t0) / (double)n;
+}
+
+//-----------------------------------------------------------------------------
+// output checksum (FNV-1a)
+
+static uint32_t axp_hash(uint32_t h, const void *buf, size_t n) {
+	const uint8_t *p = (const uint8_t *)buf;
+	for (size_t i = 0; i < n; i++) {
+		h = (h ^ p[i]) * 16777619;
+	}
+	return h;
+}
+
+#define AXP_HASH_INIT 2166136261U
+
+//-----------------------------------------------------------------------------
+// wav file: 16 bit stereo
+
+struct axp_wav {
+	FILE *f;
+	uint32_t frames;
+};
+
+static void axp_wr16(FILE * f, uint16_t x) {
+	fputc(x & 0xff, f);
+	fputc(x >> 8, f);
+}
+
+static void axp_wr32(FILE * f, uint32_t x) {
+	axp_wr16(f, x & 0xffff);
+	axp_wr16(f, x >> 16);
+}
+
+static void axp_wav_header(struct axp_wav *w) {
+	uint32_t size = w->frames * 4;
+	fseek(w->f, 0, SEEK_SET);
+	fwrite("RIFF", 1, 4, w->f);
+	axp_wr32(w->f, 36 + size);
+	fwrite("WAVEfmt ", 1, 8, w->f);
+	axp_wr32(w->f, 16);
+	axp_wr16(w->f, 1);	// pcm
+	axp_wr16(w->f, 2);	// channels
+	axp_wr32(w->f, SAMPLERATE);
+	axp_wr32(w->f, SAMPLERATE * 4);	// bytes per second
+	axp_wr16(w->f, 4);	// bytes per frame
+	axp_wr16(w->f, 16);	// bits per sample
+	fwrite("data", 1, 4, w->f);
+	axp_wr32(w->f, size);
+}
+
+static int axp_wav_open(struct axp_wav *w, const char *path) {
+	w->frames = 0;
+	w->f = fopen(path, "wb");
+	if (w->f == NULL) {
+		return -1;
+	}
+	axp_wav_header(w);
+	return 0;
+}
+
+// q5.27 to 16 bits (saturated)
+static int16_t axp_wav_sample(int32_t x) {
+	x >>= 12;
+	if (x > INT16_MAX) {
+		return INT16_MAX;
+	}
+	if (x < INT16_MIN) {
+		return INT16_MIN;
+	}
+	return (int16_t) x;
+}
+
+static void axp_wav_write(struct axp_wav *w, const int32_t * l, const int32_t * r) {
+	for (size_t i = 0; i < BUFSIZE; i++) {
+		axp_wr16(w->f, axp_wav_sample(l[i]));
+		axp_wr16(w->f, axp_wav_sample(r[i]));
+	}
+	w->frames += BUFSIZE;
+}
+
+static void axp_wav_close(struct axp_wav *w) {
+	axp_wav_header(w);
+	fclose(w->f);
+}
+
+//-----------------------------------------------------------------------------
+
+#endif				// DEADSY_AXPRUN_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,473 @@
+#!/usr/bin/env python3
+#------------------------------------------------------------------------------
+"""
+
+Run an Axoloti patch (.axp) on the host.
+
+Usage: axprun.py [--blocks N] [--wav file] [--prof] [--check hash] patch.axp
+
+The objects in the patch are looked up (by uuid, then by type) in the .axo
+files under work/objects. Their declaration/init/krate code is generated into
+a C++ program (build/<patch>.cpp) that is built against the host shim
+(shim.h, axprun.h) and run.
+
+Factory objects, and objects that need hardware (they have <depends>, or use
+the driver header of an object that does), are stubbed: their outlets are
+zero. --wav writes the inlets of an audio/out
+object to a 16 bit stereo WAV file.
+
+The report has the throughput of the whole patch (blocks/sec and the
+fraction of a k-rate period used on the host) and the time per block of each
+object. The patch time is the sum of the object times (each net of the timer
+overhead), it is n/a when every object is stubbed. The hash covers the value of every net for every block. --check
+compares it with an expected value (exit status 1 on a mismatch). --prof
+builds with PROF_ENABLE=1 so the objects also log their own profiles.
+
+"""
+#------------------------------------------------------------------------------
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import xml.etree.ElementTree as ET
+
+#------------------------------------------------------------------------------
+
+_bench_dir = os.path.dirname(os.path.abspath(__file__))
+_build_dir = os.path.join(_bench_dir, 'build')
+_objects_dir = os.path.join(_bench_dir, '..', 'objects')
+
+_cxx = os.environ.get('CXX', 'g++')
+_cxxflags = '-O2 -Wall -Wno-unused-function -Wno-unused-parameter -Wno-unused-variable'
+
+#------------------------------------------------------------------------------
+
+def pr_error(msg, cond):
+  """upon condition, print an error message and exit"""
+  if cond:
+    print(msg)
+    sys.exit(-1)
+
+def pr_warning(msg):
+  """print a warning message"""
+  print('warning: %s' % msg)
+
+def c_name(name):
+  """return a c identifier for a name"""
+  return re.sub(r'[^A-Za-z0-9_]', '_', name)
+
+#------------------------------------------------------------------------------
+# object definitions
+
+class io(object):
+  """an inlet or outlet"""
+
+  def __init__(self, elem):
+    self.name = elem.get('name')
+    self.type = elem.tag
+
+  def kind(self):
+    """return the storage kind: buffer, charptr or scalar"""
+    if 'buffer' in self.type:
+      return 'buffer'
+    if self.type.startswith('charptr'):
+      return 'charptr'
+    return 'scalar'
+
+class objdef(object):
+  """an object definition from an .axo file"""
+
+  def __init__(self, elem, path):
+    self.id = elem.get('id')
+    self.uuid = elem.get('uuid')
+    self.dir = os.path.dirname(path)
+    self.type = '%s/%s' % (os.path.basename(self.dir), self.id)
+    self.inlets = [io(x) for x in elem.find('inlets') or []]
+    self.outlets = [io(x) for x in elem.find('outlets') or []]
+    self.attribs = list(elem.find('attribs') or [])
+    self.params = list(elem.find('params') or [])
+    self.includes = [os.path.normpath(os.path.join(self.dir, x.text)) for x in elem.iter('include')]
+    self.depends = [x.text for x in elem.iter('depend')]
+    self.hw = [] # hardware driver headers used by the object
+    self.code = {}
+    for section in ('declaration', 'init', 'dispose', 'krate', 'srate'):
+      x = elem.find('code.%s' % section)
+      self.code[section] = x.text if (x is not None and x.text) else ''
+
+def read_objdefs(path):
+  """return a dictionary (by uuid and type) of the object definitions under a path"""
+  defs = {}
+  for root, _, files in os.walk(path):
+    for f in sorted(files):
+      if not f.endswith('.axo'):
+        continue
+      fname = os.path.join(root, f)
+      for elem in ET.parse(fname).getroot():
+        if not elem.tag.startswith('obj.'):
+          continue
+        d = objdef(elem, fname)
+        defs[d.uuid] = d
+        defs[d.type] = d
+  # the local includes of objects with <depends> are hardware drivers
+  hw = set()
+  for d in defs.values():
+    if d.depends:
+      hw.update([x for x in d.includes if os.path.dirname(x) == os.path.normpath(d.dir)])
+  for d in defs.values():
+    d.hw = [os.path.basename(x) for x in d.includes if x in hw]
+  return defs
+
+#------------------------------------------------------------------------------
+# patch
+
+class instance(object):
+  """an object instance in a patch"""
+
+  def __init__(self, elem, defs):
+    self.name = elem.get('name')
+    self.type = elem.get('type')
+    self.cname = c_name(self.name)
+    self.attribs = {}
+    for x in elem.find('attribs') or []:
+      self.attribs[x.get('attributeName')] = x.get('selection', x.get('value'))
+    self.params = {}
+    for x in elem.find('params') or []:
+      self.params[x.get('name')] = float(x.get('value', '0'))
+    self.defn = defs.get(elem.get('uuid'), defs.get(self.type))
+    self.stub = self.defn is None
+    if self.stub and not self.is_audio_out():
+      pr_warning('%s (%s) is not a local object, stubbed' % (self.name, self.type))
+    if self.defn is not None and self.defn.depends:
+      pr_warning('%s (%s) needs %s, stubbed' % (self.name, self.type, ' '.join(self.defn.depends)))
+      self.stub = True
+    elif self.defn is not None and self.defn.hw:
+      pr_warning('%s (%s) needs %s, stubbed' % (self.name, self.type, ' '.join(self.defn.hw)))
+      self.stub = True
+    if self.defn is not None and self.defn.code['srate']:
+      pr_warning('%s (%s) has s-rate code, stubbed' % (self.name, self.type))
+      self.stub = True
+
+  def is_audio_out(self):
+    return self.type.startswith('audio/out')
+
+  def inlet(self, name):
+    """return the inlet definition for a name"""
+    if self.stub:
+      return None
+    for x in self.defn.inlets:
+      if x.name == name:
+        return x
+    return None
+
+  def outlet(self, name):
+    """return the outlet definition for a name"""
+    if self.stub:
+      return None
+    for x in self.defn.outlets:
+      if x.name == name:
+        return x
+    return None
+
+  def attr_value(self, attr):
+    """return the c value of an attribute"""
+    name = attr.get('name')
+    val = self.attribs.get(name)
+    if attr.tag == 'combo':
+      menu = [x.text for x in attr.find('MenuEntries')]
+      centries = [x.text for x in attr.find('CEntries')]
+      if val in menu:
+        return centries[menu.index(val)]
+      if val is not None:
+        pr_warning('%s: bad %s selection "%s", using the default' % (self.name, name, val))
+      return centries[0]
+    if val is None:
+      val = attr.get('DefaultValue', '0')
+    return val
+
+  def subst(self, code):
+    """substitute the attribute and parameter values in the code"""
+    values = {'name': self.name, 'legal_name': self.cname}
+    for attr in self.defn.attribs:
+      values[attr.get('name')] = self.attr_value(attr)
+    for k in sorted(values, key=len, reverse=True):
+      code = re.sub(r'\battr_%s\b' % k, values[k], code)
+    for param in self.defn.params:
+      name = param.get('name')
+      val = int(self.params.get(name, 0.0) * (1 << 21))
+      code = re.sub(r'\bparam_%s\b' % name, '%d' % val, code)
+    return code
+
+class net(object):
+  """a net (one source, n destinations)"""
+
+  def __init__(self, elem, idx):
+    self.cname = 'net_%d' % idx
+    src = elem.find('source')
+    self.src = (src.get('obj'), src.get('outlet'))
+    self.dst = [(x.get('obj'), x.get('inlet')) for x in elem.findall('dest')]
+    self.kind = 'buffer'
+
+def read_patch(fname, defs):
+  """return the instances and nets of a patch"""
+  root = ET.parse(fname).getroot()
+  objs = [instance(x, defs) for x in root.findall('obj')]
+  nets = [net(x, i) for (i, x) in enumerate(root.find('nets') or [])]
+  by_name = dict((x.name, x) for x in objs)
+  # storage kind: from the source outlet, or else from a destination inlet
+  for n in nets:
+    ios = [by_name[n.src[0]].outlet(n.src[1])]
+    ios.extend([by_name[o].inlet(i) for (o, i) in n.dst])
+    ios = [x for x in ios if x is not None]
+    if ios:
+      n.kind = ios[0].kind()
+  return objs, nets
+
+#------------------------------------------------------------------------------
+# code generation
+
+_ctype = {
+  'buffer': 'int32buffer',
+  'charptr': 'char *',
+  'scalar': 'int32_t',
+}
+
+_cinlet = {
+  'buffer': 'const int32_t *',
+  'charptr': 'const char *',
+  'scalar': 'const int32_t ',
+}
+
+_czero = {
+  'buffer': 'axp_zero_buf',
+  'charptr': '(const char *)0',
+  'scalar': '0',
+}
+
+_main = '''
+int main(int argc, char *argv[]) {
+	uint32_t blocks = (uint32_t) strtoul(argv[1], NULL, 0);
+	const char *wav = (argc > 2) ? argv[2] : NULL;
+	double t[AXP_OBJECTS] = { 0 };
+	uint32_t hash = AXP_HASH_INIT;
+
+	// time per object, net hash and audio output
+	struct axp_wav w;
+	if (wav != NULL && axp_wav_open(&w, wav) != 0) {
+		fprintf(stderr, "can't open %s\\n", wav);
+		return 1;
+	}
+	double overhead = axp_timer_overhead();
+	shim_init();
+	axp_init();
+	for (uint32_t n = 0; n < blocks; n++) {
+		axp_krate_timed(t);
+		hash = axp_hash_nets(hash);
+		if (wav != NULL) {
+			axp_audio(&w);
+		}
+	}
+	axp_dispose();
+	if (wav != NULL) {
+		axp_wav_close(&w);
+	}
+
+	// The patch time is the sum of the object times, so the timer overhead is
+	// taken out of both in the same way.
+	double ns[AXP_OBJECTS];
+	double total = 0.0;
+	for (int i = 0; i < AXP_OBJECTS; i++) {
+		ns[i] = (t[i] / (double)blocks) - overhead;
+		ns[i] = (ns[i] > 0.0) ? ns[i] : 0.0;
+		total += ns[i];
+	}
+
+	printf("{\\n");
+	printf("  \\"bufsize\\": %d,\\n", BUFSIZE);
+	printf("  \\"samplerate\\": %d,\\n", SAMPLERATE);
+	printf("  \\"blocks\\": %u,\\n", blocks);
+	printf("  \\"ns_per_block\\": %.2f,\\n", total);
+	printf("  \\"hash\\": \\"%08x\\",\\n", hash);
+	printf("  \\"objects\\": {");
+	const char *sep = "\\n";
+	for (int i = 0; i < AXP_OBJECTS; i++) {
+		printf("%s    \\"%s\\": {\\"type\\": \\"%s\\", \\"ns_per_block\\": %.2f}", sep, axp_names[i], axp_types[i], ns[i]);
+		sep = ",\\n";
+	}
+	printf("\\n  }\\n");
+	printf("}\\n");
+	return 0;
+}
+'''
+
+def gen_object(o, nets):
+  """return the class definition for an object instance"""
+  d = o.defn
+  args = []
+  for x in d.inlets:
+    args.append('%sinlet_%s' % (_cinlet[x.kind()], x.name))
+  for x in d.outlets:
+    args.append('%s &outlet_%s' % (_ctype[x.kind()], x.name))
+  s = []
+  s.append('// %s (%s)' % (o.name, o.type))
+  s.append('struct obj_%s {' % o.cname)
+  s.append(o.subst(d.code['declaration']))
+  s.append('void init(void) {')
+  s.append(o.subst(d.code['init']))
+  s.append('}')
+  s.append('void dispose(void) {')
+  s.append(o.subst(d.code['dispose']))
+  s.append('}')
+  s.append('void krate(%s) {' % ', '.join(args))
+  s.append(o.subst(d.code['krate']))
+  s.append('}')
+  s.append('};')
+  s.append('')
+  s.append('static struct obj_%s %s;' % (o.cname, o.cname))
+  for x in d.outlets:
+    if find_net(nets, (o.name, x.name)) is None:
+      s.append('static %s %s_%s;' % (_ctype[x.kind()], o.cname, x.name))
+  s.append('')
+  return s
+
+def find_net(nets, src=None, dst=None):
+  """return the net with a source or destination"""
+  for n in nets:
+    if src is not None and n.src == src:
+      return n
+    if dst is not None and dst in n.dst:
+      return n
+  return None
+
+def gen_call(o, nets):
+  """return the krate call for an object instance"""
+  args = []
+  for x in o.defn.inlets:
+    n = find_net(nets, dst=(o.name, x.name))
+    args.append(_czero[x.kind()] if n is None else n.cname)
+  for x in o.defn.outlets:
+    n = find_net(nets, src=(o.name, x.name))
+    args.append('%s_%s' % (o.cname, x.name) if n is None else n.cname)
+  return '%s.krate(%s);' % (o.cname, ', '.join(args))
+
+def gen_patch(fname, objs, nets):
+  """return the c++ program for a patch"""
+  local = [o for o in objs if not o.stub]
+  includes = [os.path.join(_bench_dir, 'axprun.h')]
+  for o in local:
+    includes.extend([x for x in o.defn.includes if x not in includes])
+  s = []
+  s.append('// generated by axprun.py from %s' % os.path.basename(fname))
+  s.append('')
+  s.extend(['#include "%s"' % x for x in includes])
+  s.append('')
+  for n in nets:
+    s.append('static %s %s;' % (_ctype[n.kind], n.cname))
+  s.append('')
+  for o in local:
+    s.extend(gen_object(o, nets))
+  s.append('#define AXP_OBJECTS %d' % max(len(local), 1))
+  s.append('static const char *axp_names[AXP_OBJECTS] = {%s};' % ', '.join(['"%s"' % o.name for o in local] or ['""']))
+  s.append('static const char *axp_types[AXP_OBJECTS] = {%s};' % ', '.join(['"%s"' % o.type for o in local] or ['""']))
+  s.append('')
+  s.append('static void axp_init(void) {')
+  s.extend(['\t%s.init();' % o.cname for o in local])
+  s.append('}')
+  s.append('')
+  s.append('static void axp_dispose(void) {')
+  s.extend(['\t%s.dispose();' % o.cname for o in local])
+  s.append('}')
+  s.append('')
+  s.append('static void axp_krate_timed(double *t) {')
+  s.append('\tdouble t0 = axp_now_ns();')
+  for (i, o) in enumerate(local):
+    s.append('\t%s' % gen_call(o, nets))
+    s.append('\tdouble t%d = axp_now_ns();' % (i + 1))
+    s.append('\tt[%d] += t%d - t%d;' % (i, i + 1, i))
+  s.append('}')
+  s.append('')
+  s.append('static uint32_t axp_hash_nets(uint32_t h) {')
+  for n in nets:
+    if n.kind == 'charptr':
+      continue
+    s.append('\th = axp_hash(h, &%s, sizeof(%s));' % (n.cname, n.cname))
+  s.append('\treturn h;')
+  s.append('}')
+  s.append('')
+  s.append('static void axp_audio(struct axp_wav *w) {')
+  for o in objs:
+    if o.is_audio_out():
+      ch = []
+      for inlet in ('left', 'right'):
+        n = find_net(nets, dst=(o.name, inlet))
+        ch.append('axp_zero_buf' if (n is None or n.kind != 'buffer') else n.cname)
+      s.append('\taxp_wav_write(w, %s, %s);' % (ch[0], ch[1]))
+      break
+  s.append('}')
+  s.append(_main)
+  return '\n'.join(s)
+
+#------------------------------------------------------------------------------
+
+def build(src, exe, flags):
+  """build the generated program"""
+  cmd = '%s %s %s -o %s %s -lm' % (_cxx, _cxxflags, flags, exe, src)
+  rc = subprocess.call(cmd, shell=True)
+  pr_error('%s: build failed' % src, rc != 0)
+
+def report(fname, results):
+  """print the results"""
+  krate_ns = 1e9 * results['bufsize'] / results['samplerate']
+  ns = results['ns_per_block']
+  if ns > 0.0:
+    print('%s: %d blocks, %.0f blocks/sec, %.2f ns/block (%.2f%% k-rate)' % (fname, results['blocks'], 1e9 / ns, ns, 100.0 * ns / krate_ns))
+  else:
+    # every object is stubbed
+    print('%s: %d blocks, n/a blocks/sec, n/a ns/block' % (fname, results['blocks']))
+  print('%-20s %-20s %12s %8s' % ('object', 'type', 'ns/block', 'k-rate'))
+  for name, r in results['objects'].items():
+    if not name:
+      continue
+    print('%-20s %-20s %12.2f %7.2f%%' % (name, r['type'], r['ns_per_block'], 100.0 * r['ns_per_block'] / krate_ns))
+  print('hash %s' % results['hash'])
+
+#------------------------------------------------------------------------------
+
+def main():
+  parser = argparse.ArgumentParser(description='run an axoloti patch on the host')
+  parser.add_argument('patch', help='patch file (.axp)')
+  parser.add_argument('--blocks', type=int, default=100000, help='blocks per run')
+  parser.add_argument('--wav', default=None, help='write the audio output to a wav file')
+  parser.add_argument('--prof', action='store_true', help='build with PROF_ENABLE=1')
+  parser.add_argument('--check', default=None, help='expected hash')
+  args = parser.parse_args()
+
+  defs = read_objdefs(_objects_dir)
+  objs, nets = read_patch(args.patch, defs)
+
+  if not os.path.isdir(_build_dir):
+    os.mkdir(_build_dir)
+  name = c_name(os.path.splitext(os.path.basename(args.patch))[0])
+  src = os.path.join(_build_dir, '%s.cpp' % name)
+  exe = os.path.join(_build_dir, name)
+  f = open(src, 'w')
+  f.write(gen_patch(args.patch, objs, nets))
+  f.close()
+  build(src, exe, '-DPROF_ENABLE=1' if args.prof else '')
+
+  cmd = [exe, '%d' % args.blocks]
+  if args.wav:
+    cmd.append(args.wav)
+  output = subprocess.check_output(cmd).decode()
+  results = json.loads(output)
+  report(args.patch, results)
+
+  if args.check is not None and args.check != results['hash']:
+    print('hash mismatch: expected %s' % args.check)
+    sys.exit(1)
+
+main()
+
+#------------------------------------------------------------------------------
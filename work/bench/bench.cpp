@@ -0,0 +1,375 @@
+//-----------------------------------------------------------------------------
+/*
+
+DSP Kernel Benchmarks
+
+Runs the k-rate kernels from work/objects against the host shim and reports
+the time per block. Results are written to stdout as JSON (see bench.py).
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "shim.h"
+#include "../objects/noise/noise.h"
+#include "../objects/osc/goom.h"
+#include "../objects/input/strum.h"
+
+//-----------------------------------------------------------------------------
+
+#define BENCH_BLOCKS 100000	// blocks per run
+#define BENCH_RUNS 7		// runs per kernel (the fastest is reported)
+
+//-----------------------------------------------------------------------------
+// kernel wrappers
+
+static struct noise_state noise;
+static struct voss_state voss;
+static struct noise_state noise8[NOISE_LANES];
+static struct noise_bank_state bank;
+static struct tilt_state tilt;
+static struct velvet_state velvet;
+static struct multi_noise_state multi;
+static struct goom_state goom;
+static struct goom_state goom8[8];
+static struct goom_poly_state poly;
+static struct strum_state strum;
+
+static void noise_setup(void) {
+	noise_init(&noise, 0);
+}
+
+static void voss_setup(void) {
+	voss_init(&voss, 0);
+}
+
+static void noise8_setup(void) {
+	for (size_t l = 0; l < NOISE_LANES; l++) {
+		noise_init(&noise8[l], 0);
+	}
+}
+
+static void bank_setup(void) {
+	noise_bank_init(&bank, 0);
+}
+
+static void tilt_setup(void) {
+	tilt_init(&tilt, 0);
+}
+
+static void velvet_setup(void) {
+	velvet_init(&velvet, 0);
+}
+
+static void multi_setup(void) {
+	multi_noise_init(&multi, 0);
+}
+
+static void goom_setup(void) {
+	goom_init(&goom);
+}
+
+static void white_run(int32_t * out, uint32_t n) {
+	white_noise(&noise, out);
+}
+
+static void brown_run(int32_t * out, uint32_t n) {
+	brown_noise(&noise, out);
+}
+
+static void pink1_run(int32_t * out, uint32_t n) {
+	pink_noise1(&noise, out);
+}
+
+static void pink2_run(int32_t * out, uint32_t n) {
+	pink_noise2(&noise, out);
+}
+
+static void pink3_run(int32_t * out, uint32_t n) {
+	pink_noise3(&voss, out);
+}
+
+// 8 separate pink_noise2 instances versus an 8 lane bank
+static int32_t lane_buf[NOISE_LANES][BUFSIZE];
+static int32_t *lane_out[NOISE_LANES] = {
+	lane_buf[0], lane_buf[1], lane_buf[2], lane_buf[3],
+	lane_buf[4], lane_buf[5], lane_buf[6], lane_buf[7],
+};
+
+static void pink2_x8_run(int32_t * out, uint32_t n) {
+	for (size_t l = 0; l < NOISE_LANES; l++) {
+		pink_noise2(&noise8[l], lane_out[l]);
+	}
+	memcpy(out, lane_out[n & 7], sizeof(lane_buf[0]));
+}
+
+static void pink2_bank8_run(int32_t * out, uint32_t n) {
+	pink_noise2_bank(&bank, NOISE_LANES, lane_out);
+	memcpy(out, lane_out[n & 7], sizeof(lane_buf[0]));
+}
+
+static void tilt_run(int32_t * out, uint32_t n) {
+	tilt_noise(&tilt, 1 << 26, out);
+}
+
+// alpha modulated every block (coefficient ramps)
+static void tilt_mod_run(int32_t * out, uint32_t n) {
+	tilt_noise(&tilt, (n & 127) << 20, out);
+}
+
+static void velvet_run(int32_t * out, uint32_t n) {
+	velvet_noise(&velvet, 2000, out);
+}
+
+// white, brown, pink1 and pink2 as separate kernels versus the fused kernel
+static void separate4_run(int32_t * out, uint32_t n) {
+	white_noise(&noise8[0], lane_out[0]);
+	brown_noise(&noise8[1], lane_out[1]);
+	pink_noise1(&noise8[2], lane_out[2]);
+	pink_noise2(&noise8[3], lane_out[3]);
+	memcpy(out, lane_out[n & 3], sizeof(lane_buf[0]));
+}
+
+static void multi_run(int32_t * out, uint32_t n) {
+	multi_noise(&multi, lane_out[0], lane_out[1], lane_out[2], lane_out[3]);
+	memcpy(out, lane_out[n & 3], sizeof(lane_buf[0]));
+}
+
+static void brown_q31_run(int32_t * out, uint32_t n) {
+	brown_noise_q31(&noise, out);
+}
+
+static void pink1_q31_run(int32_t * out, uint32_t n) {
+	pink_noise1_q31(&noise, out);
+}
+
+static void pink2_q31_run(int32_t * out, uint32_t n) {
+	pink_noise2_q31(&noise, out);
+}
+
+static const int32_t zero_buf[BUFSIZE] = { 0 };
+
+// sweep the pitch, goom_krate_mod also sweeps the duty (shape update path)
+static void goom_run(int32_t * out, uint32_t n) {
+	int32_t pitch = (int32_t) ((n & 63) << 21) - (32 << 21);
+	goom_krate(&goom, pitch, zero_buf, zero_buf, 64, 64, out);
+}
+
+static void goom_mod_run(int32_t * out, uint32_t n) {
+	int32_t pitch = (int32_t) ((n & 63) << 21) - (32 << 21);
+	goom_krate(&goom, pitch, zero_buf, zero_buf, n & 127, 64, out);
+}
+
+// minimum slope: the wave is mostly flat
+static void goom_flat_run(int32_t * out, uint32_t n) {
+	int32_t pitch = (int32_t) ((n & 63) << 21) - (32 << 21);
+	goom_krate(&goom, pitch, zero_buf, zero_buf, 64, 0, out);
+}
+
+// audio rate fm (per sample path)
+static int32_t fm_buf[BUFSIZE];
+
+static void goom_fm_setup(void) {
+	goom_init(&goom);
+	for (size_t i = 0; i < BUFSIZE; i++) {
+		fm_buf[i] = sin_q31((uint32_t) i << 28) >> 8;
+	}
+}
+
+static void goom_fm_run(int32_t * out, uint32_t n) {
+	int32_t pitch = (int32_t) ((n & 63) << 21) - (32 << 21);
+	goom_krate(&goom, pitch, fm_buf, zero_buf, 64, 64, out);
+}
+
+// blep mode (corner corrections)
+static void goom_blep_run(int32_t * out, uint32_t n) {
+	int32_t pitch = (int32_t) ((n & 63) << 21) - (32 << 21);
+	goom_blep_krate(&goom, pitch, zero_buf, zero_buf, 64, 64, out);
+}
+
+// table mode (cached shape)
+static void goom_table_run(int32_t * out, uint32_t n) {
+	int32_t pitch = (int32_t) ((n & 63) << 21) - (32 << 21);
+	goom_table_krate(&goom, pitch, zero_buf, zero_buf, 64, 64, out);
+}
+
+// 8 separate goom instances versus an 8 voice bank (chord: held pitches)
+static const int32_t chord[GOOM_VOICES] = {
+	0 << 21, 4 << 21, 7 << 21, 11 << 21, 12 << 21, 16 << 21, 19 << 21, 23 << 21,
+	24 << 21, 28 << 21, 31 << 21, 35 << 21, 36 << 21, 40 << 21, 43 << 21, 47 << 21,
+};
+
+static const int32_t shape[GOOM_VOICES] = {
+	64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+};
+
+// outputs for all of the bank voices (the first 8 are the lane buffers)
+static int32_t voice_buf[GOOM_VOICES - 8][BUFSIZE];
+static int32_t *voice_out[GOOM_VOICES] = {
+	lane_buf[0], lane_buf[1], lane_buf[2], lane_buf[3],
+	lane_buf[4], lane_buf[5], lane_buf[6], lane_buf[7],
+	voice_buf[0], voice_buf[1], voice_buf[2], voice_buf[3],
+	voice_buf[4], voice_buf[5], voice_buf[6], voice_buf[7],
+};
+
+static void goom8_setup(void) {
+	for (size_t v = 0; v < 8; v++) {
+		goom_init(&goom8[v]);
+	}
+}
+
+static void poly_setup(void) {
+	goom_poly_init(&poly);
+}
+
+static void goom_x8_run(int32_t * out, uint32_t n) {
+	for (size_t v = 0; v < 8; v++) {
+		goom_krate(&goom8[v], chord[v], zero_buf, zero_buf, 64, 64, lane_out[v]);
+	}
+	memcpy(out, lane_out[n & 7], sizeof(lane_buf[0]));
+}
+
+static void goom_poly8_run(int32_t * out, uint32_t n) {
+	int32_t mix[BUFSIZE];
+	goom_poly_krate(&poly, 8, chord, shape, shape, mix, voice_out);
+	memcpy(out, lane_out[n & 7], sizeof(lane_buf[0]));
+}
+
+static void goom_poly16_run(int32_t * out, uint32_t n) {
+	int32_t mix[BUFSIZE];
+	goom_poly_krate(&poly, GOOM_VOICES, chord, shape, shape, mix, voice_out);
+	memcpy(out, voice_out[n & 15], sizeof(lane_buf[0]));
+}
+
+// strum up and down the strings (one string changes per block), with a
+// chord change every 32 blocks
+static const struct strum_cfg strum_config = {
+	.touch_bits = 12,
+	.device = MIDI_DEVICE_DIN,
+	.port = 1,
+	.channel = 0,
+	.base = 48,
+	.velocity = 100,
+};
+
+static void strum_setup(void) {
+	strum_init(&strum, &strum_config);
+}
+
+static void strum_run(int32_t * out, uint32_t n) {
+	uint32_t i = n % 24;
+	int32_t touch = (i < 12) ? (1 << (i + 1)) - 1 : (1 << (24 - i)) - 1;
+	int32_t gate;
+	if ((n & 31) == 0) {
+		strum_key(&strum, STRUM_EVENT_KEYDN, (n >> 5) & 63);
+	}
+	strum_krate(&strum, touch, &out[0], &gate);
+	out[n & (BUFSIZE - 1)] = gate;
+}
+
+//-----------------------------------------------------------------------------
+
+struct bench_kernel {
+	const char *name;
+	void (*setup)(void);
+	void (*run)(int32_t * out, uint32_t n);
+};
+
+static const struct bench_kernel kernels[] = {
+	{"white_noise", noise_setup, white_run},
+	{"brown_noise", noise_setup, brown_run},
+	{"pink_noise1", noise_setup, pink1_run},
+	{"pink_noise2", noise_setup, pink2_run},
+	{"pink_noise3", voss_setup, pink3_run},
+	{"brown_noise_q31", noise_setup, brown_q31_run},
+	{"pink_noise1_q31", noise_setup, pink1_q31_run},
+	{"pink_noise2_q31", noise_setup, pink2_q31_run},
+	{"pink_noise2_x8", noise8_setup, pink2_x8_run},
+	{"pink_noise2_bank8", bank_setup, pink2_bank8_run},
+	{"tilt_noise", tilt_setup, tilt_run},
+	{"tilt_noise_mod", tilt_setup, tilt_mod_run},
+	{"velvet_noise", velvet_setup, velvet_run},
+	{"noise_separate4", noise8_setup, separate4_run},
+	{"multi_noise", multi_setup, multi_run},
+	{"goom_krate", goom_setup, goom_run},
+	{"goom_krate_mod", goom_setup, goom_mod_run},
+	{"goom_krate_flat", goom_setup, goom_flat_run},
+	{"goom_krate_fm", goom_fm_setup, goom_fm_run},
+	{"goom_blep_krate", goom_setup, goom_blep_run},
+	{"goom_table_krate", goom_setup, goom_table_run},
+	{"goom_x8", goom8_setup, goom_x8_run},
+	{"goom_poly8", poly_setup, goom_poly8_run},
+	{"goom_poly16", poly_setup, goom_poly16_run},
+	{"strum_krate", strum_setup, strum_run},
+};
+
+#define NUM_KERNELS (sizeof(kernels) / sizeof(struct bench_kernel))
+
+//-----------------------------------------------------------------------------
+
+static double now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// return the best case ns/block for a kernel
+static double bench(const struct bench_kernel *k, uint32_t blocks, int32_t * check) {
+	int32_t out[BUFSIZE];
+	double best = 0.0;
+	for (int r = 0; r < BENCH_RUNS; r++) {
+		shim_init();
+		k->setup();
+		double t0 = now_ns();
+		for (uint32_t n = 0; n < blocks; n++) {
+			k->run(out, n);
+			// keep the compiler honest
+			*check += out[n & (BUFSIZE - 1)];
+		}
+		double t = (now_ns() - t0) / (double)blocks;
+		if (r == 0 || t < best) {
+			best = t;
+		}
+	}
+	return best;
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+	uint32_t blocks = BENCH_BLOCKS;
+	const char *filter = NULL;
+	int32_t check = 0;
+
+	if (argc > 1) {
+		blocks = (uint32_t) strtoul(argv[1], NULL, 0);
+	}
+	if (argc > 2) {
+		filter = argv[2];
+	}
+
+	printf("{\n");
+	printf("  \"bufsize\": %d,\n", BUFSIZE);
+	printf("  \"samplerate\": %d,\n", SAMPLERATE);
+	printf("  \"blocks\": %u,\n", blocks);
+	printf("  \"kernels\": {");
+	const char *sep = "\n";
+	for (size_t i = 0; i < NUM_KERNELS; i++) {
+		const struct bench_kernel *k = &kernels[i];
+		if (filter != NULL && strstr(k->name, filter) == NULL) {
+			continue;
+		}
+		double ns = bench(k, blocks, &check);
+		printf("%s    \"%s\": {\"ns_per_block\": %.2f, \"samples_per_sec\": %.0f}", sep, k->name, ns, (double)BUFSIZE * 1e9 / ns);
+		sep = ",\n";
+	}
+	printf("\n  },\n");
+	printf("  \"check\": %d\n", check);
+	printf("}\n");
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+#------------------------------------------------------------------------------
+"""
+
+Build and run the host DSP kernel benchmarks.
+
+Usage: bench.py [--save] [--blocks N] [--filter name] [--threshold pct]
+                [--bufsize N[,N...]] [--check] [--eval] [--csv file]
+
+Results are compared with the saved baseline (baseline.json) and any kernel
+that is slower than the baseline by more than the threshold is flagged as a
+regression (non-zero exit status). --save writes the results as the new
+baseline, it can't be combined with --filter since the baseline must cover
+every kernel.
+
+--bufsize builds and runs the benchmarks for each block size (the kernels
+are compiled with -DBUFSIZE=N). Only a run with the baseline block size is
+compared with the baseline.
+
+--check runs the float/fixed point spectrum checks and the velvet/goom output
+checks (spectrum.cpp) instead of the benchmarks. --eval runs the spectral
+accuracy versus cost evaluation of the noise generators, --csv also writes the
+evaluation results to a file.
+
+Numbers are for the host CPU. The k-rate budget column is the fraction of a
+k-rate period (BUFSIZE/SAMPLERATE) used by the kernel on the host, it's only
+useful for comparing kernels with each other.
+
+"""
+#------------------------------------------------------------------------------
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+#------------------------------------------------------------------------------
+
+_bench_dir = os.path.dirname(os.path.abspath(__file__))
+_build_dir = os.path.join(_bench_dir, 'build')
+_baseline = os.path.join(_bench_dir, 'baseline.json')
+
+_cxx = os.environ.get('CXX', 'g++')
+_cxxflags = '-O2 -Wall -Wno-unused-function -Wno-unused-parameter'
+
+#------------------------------------------------------------------------------
+
+def pr_error(msg, cond):
+  """upon condition, print an error message and exit"""
+  if cond:
+    print(msg)
+    sys.exit(-1)
+
+def exec_cmd(cmd):
+  """execute a command, return the output and return code"""
+  output = ''
+  rc = 0
+  try:
+    output = subprocess.check_output(cmd, shell=True).decode()
+  except subprocess.CalledProcessError as x:
+    rc = x.returncode
+  return output, rc
+
+#------------------------------------------------------------------------------
+
+def build(name, flags='', suffix=''):
+  """build a host program from <name>.cpp, return the executable path"""
+  if not os.path.isdir(_build_dir):
+    os.mkdir(_build_dir)
+  src = os.path.join(_bench_dir, '%s.cpp' % name)
+  exe = os.path.join(_build_dir, name + suffix)
+  _, rc = exec_cmd('%s %s %s -o %s %s -lm' % (_cxx, _cxxflags, flags, exe, src))
+  pr_error('%s: build failed' % name, rc != 0)
+  return exe
+
+def run(exe, blocks, name_filter):
+  """run the benchmark, return the results"""
+  cmd = '%s %d' % (exe, blocks)
+  if name_filter:
+    cmd += ' %s' % name_filter
+  output, rc = exec_cmd(cmd)
+  pr_error('%s: run failed' % exe, rc != 0)
+  return json.loads(output)
+
+#------------------------------------------------------------------------------
+
+def report(results, baseline, threshold):
+  """print the results, return the list of regressed kernels"""
+  krate_ns = 1e9 * results['bufsize'] / results['samplerate']
+  base = {}
+  if baseline is not None:
+    base = baseline['kernels']
+  regressed = []
+  print('%-20s %12s %14s %8s %10s' % ('kernel', 'ns/block', 'samples/sec', 'k-rate', 'baseline'))
+  for name, r in results['kernels'].items():
+    ns = r['ns_per_block']
+    budget = '%.2f%%' % (100.0 * ns / krate_ns)
+    delta = ''
+    if name in base:
+      pct = 100.0 * (ns - base[name]['ns_per_block']) / base[name]['ns_per_block']
+      delta = '%+.1f%%' % pct
+      if pct > threshold:
+        delta += ' REGRESSION'
+        regressed.append(name)
+    print('%-20s %12.2f %14.0f %8s %10s' % (name, ns, r['samples_per_sec'], budget, delta))
+  return regressed
+
+#------------------------------------------------------------------------------
+
+def main():
+  parser = argparse.ArgumentParser(description='host dsp kernel benchmarks')
+  parser.add_argument('--save', action='store_true', help='save the results as the baseline')
+  parser.add_argument('--blocks', type=int, default=100000, help='blocks per run')
+  parser.add_argument('--filter', default=None, help='only run kernels matching this name')
+  parser.add_argument('--threshold', type=float, default=15.0, help='regression threshold (percent)')
+  parser.add_argument('--bufsize', default='16', help='block size(s), comma separated')
+  parser.add_argument('--check', action='store_true', help='run the spectrum and output checks')
+  parser.add_argument('--eval', action='store_true', help='run the spectral accuracy versus cost evaluation')
+  parser.add_argument('--csv', default=None, help='csv file for the evaluation results')
+  args = parser.parse_args()
+
+  if args.check:
+    exe = build('spectrum')
+    sys.exit(subprocess.call([exe, 'check']))
+
+  if args.eval:
+    exe = build('spectrum')
+    cmd = [exe, 'eval']
+    if args.csv:
+      cmd.extend(['%d' % (1 << 23), args.csv])
+    sys.exit(subprocess.call(cmd))
+
+  sizes = [int(x) for x in args.bufsize.split(',')]
+  pr_error('--save needs a single block size', args.save and len(sizes) != 1)
+  pr_error('--save can not be used with --filter', args.save and args.filter is not None)
+
+  baseline = None
+  if os.path.exists(_baseline):
+    f = open(_baseline, 'r')
+    baseline = json.load(f)
+    f.close()
+
+  regressed = []
+  for n in sizes:
+    exe = build('bench', '-DBUFSIZE=%d' % n, '_%d' % n)
+    results = run(exe, args.blocks, args.filter)
+    if len(sizes) > 1:
+      print('bufsize %d' % n)
+    base = baseline
+    if base is not None and base['bufsize'] != n:
+      print('baseline bufsize mismatch, not comparing')
+      base = None
+    regressed.extend(report(results, base, args.threshold))
+    if args.save:
+      f = open(_baseline, 'w')
+      json.dump(results, f, indent=2)
+      f.write('\n')
+      f.close()
+      print('saved baseline to %s' % _baseline)
+      return
+
+  if regressed:
+    print('regressions: %s' % ' '.join(regressed))
+    sys.exit(1)
+
+main()
+
+#------------------------------------------------------------------------------
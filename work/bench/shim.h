@@ -0,0 +1,140 @@
+//-----------------------------------------------------------------------------
+/*
+
+Host Shim for the Axoloti Runtime
+
+Provides host (x86/Linux) stand-ins for the Axoloti firmware/ChibiOS
+definitions used by the DSP kernels in work/objects. This allows the kernels
+to be compiled, tested and benchmarked on the host.
+
+The stand-ins follow the firmware implementations closely enough that the
+relative cost of the kernels is representative. Absolute numbers are for
+the host CPU, not the STM32F4.
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef DEADSY_SHIM_H
+#define DEADSY_SHIM_H
+
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+
+//-----------------------------------------------------------------------------
+
+#ifndef BUFSIZE
+#define BUFSIZE 16		// samples per k-rate block
+#endif
+
+#define SAMPLERATE 48000
+#define KRATE (SAMPLERATE / BUFSIZE)
+
+#define __ASM __asm__
+
+//-----------------------------------------------------------------------------
+// random numbers
+
+// firmware: the seed is stirred with the hardware rng, here it's just an lcg
+static uint32_t shim_rand_seed = 22222;
+
+static inline int32_t rand_s32(void) {
+	shim_rand_seed = (shim_rand_seed * 196314165) + 907633515;
+	return (int32_t) shim_rand_seed;
+}
+
+//-----------------------------------------------------------------------------
+// conversions
+
+// convert a float to a q5.27 (saturating, as per VCVT.S32.F32)
+static inline int32_t float_to_q27(float f) {
+	float x = f * (float)(1 << 27);
+	if (x >= 2147483647.f) {
+		return INT32_MAX;
+	}
+	if (x <= -2147483648.f) {
+		return INT32_MIN;
+	}
+	return (int32_t) x;
+}
+
+//-----------------------------------------------------------------------------
+// logging
+
+// firmware: the message goes to the gui log, here it's stderr
+static void LogTextMessage(const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+	fputc('\n', stderr);
+}
+
+//-----------------------------------------------------------------------------
+// midi
+
+typedef enum {
+	MIDI_DEVICE_DIN,
+	MIDI_DEVICE_USB_DEVICE,
+	MIDI_DEVICE_USB_HOST,
+	MIDI_DEVICE_INTERNAL = 0x0f,
+} midi_device_t;
+
+#define MIDI_NOTE_OFF 0x80
+#define MIDI_NOTE_ON 0x90
+
+// firmware: queued for the midi output, here it's just counted
+static uint32_t shim_midi_count;
+
+static void MidiSend3(midi_device_t dev, uint8_t port, uint8_t b0, uint8_t b1, uint8_t b2) {
+	shim_midi_count++;
+}
+
+//-----------------------------------------------------------------------------
+// sine
+
+#define SHIM_SINE_BITS 10
+#define SHIM_SINE_SIZE (1 << SHIM_SINE_BITS)
+
+static int32_t shim_sine[SHIM_SINE_SIZE + 1];
+
+// q31 sine of a 32 bit phase (linear interpolation of a table)
+static inline int32_t sin_q31(uint32_t phase) {
+	uint32_t idx = phase >> (32 - SHIM_SINE_BITS);
+	int32_t frac = (phase << SHIM_SINE_BITS) >> 1;
+	int32_t y0 = shim_sine[idx];
+	int32_t y1 = shim_sine[idx + 1];
+	return y0 + (int32_t) (((int64_t) (y1 - y0) * frac) >> 31);
+}
+
+//-----------------------------------------------------------------------------
+// pitch
+
+// q11.21 pitch (0 = midi note 64) to a 32 bit phase increment at 48 kHz
+static inline uint32_t mtof48k_ext_q31(int32_t pitch) {
+	float note = 64.f + (float)pitch * (1.f / (float)(1 << 21));
+	float freq = 440.f * exp2f((note - 69.f) * (1.f / 12.f));
+	return (uint32_t) (freq * (4294967296.f / (float)SAMPLERATE));
+}
+
+//-----------------------------------------------------------------------------
+
+static void shim_init(void) {
+	for (int i = 0; i <= SHIM_SINE_SIZE; i++) {
+		double x = sin(2.0 * M_PI * (double)i / (double)SHIM_SINE_SIZE);
+		shim_sine[i] = (int32_t) (x * 2147483647.0);
+	}
+	shim_rand_seed = 22222;
+	shim_midi_count = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+#endif				// DEADSY_SHIM_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,537 @@
+//-----------------------------------------------------------------------------
+/*
+
+Noise Spectrum Checks and Evaluation
+
+spectrum check [samples]
+Runs the float and fixed point versions of the colored noise kernels from the
+same seed and compares their power spectral densities (Welch's method) in
+1/3 octave bands. Exits with a non-zero status if any band differs by more
+than the tolerance. It also checks that the velvet noise impulses don't
+overlap: no output sample is above full scale and the sparse positions are
+strictly increasing. The goom blep output peak is checked against full scale
+across a grid of pitch, duty and slope values.
+
+spectrum eval [samples] [csv]
+Runs each noise generator for a long duration, fits the spectral slope to
+the 1/3 octave band levels and reports the deviation from the ideal slope
+(0/-3/-6 dB/octave) along with the cost per sample. The results are printed
+as a table and optionally written to a CSV file.
+
+*/
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "shim.h"
+#include "../objects/noise/noise.h"
+#include "../objects/osc/goom.h"
+
+//-----------------------------------------------------------------------------
+
+#define NFFT 4096		// fft size for the psd
+#define NBINS (NFFT / 2 + 1)
+#define CHECK_SAMPLES (1 << 22)	// samples per generator
+#define CHECK_TOLERANCE 0.1	// maximum band difference (dB)
+#define GOOM_CHECK_PEAK 1.1	// maximum goom blep output (relative to full scale)
+#define GOOM_CHECK_BLOCKS 64	// blocks per pitch/duty/slope
+#define EVAL_SAMPLES (1 << 23)	// samples per generator
+#define EVAL_FMIN 40.0		// slope fit range (Hz)
+#define EVAL_FMAX 16000.0
+
+//-----------------------------------------------------------------------------
+// fft
+
+// in place radix-2 complex fft, n is a power of 2
+static void fft(double *re, double *im, size_t n) {
+	// bit reversal
+	for (size_t i = 1, j = 0; i < n; i++) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+		if (i < j) {
+			double t = re[i];
+			re[i] = re[j];
+			re[j] = t;
+			t = im[i];
+			im[i] = im[j];
+			im[j] = t;
+		}
+	}
+	// butterflies
+	for (size_t len = 2; len <= n; len <<= 1) {
+		double a = -2.0 * M_PI / (double)len;
+		for (size_t i = 0; i < n; i += len) {
+			for (size_t k = 0; k < len / 2; k++) {
+				double wr = cos(a * (double)k);
+				double wi = sin(a * (double)k);
+				size_t p = i + k;
+				size_t q = p + len / 2;
+				double xr = re[q] * wr - im[q] * wi;
+				double xi = re[q] * wi + im[q] * wr;
+				re[q] = re[p] - xr;
+				im[q] = im[p] - xi;
+				re[p] += xr;
+				im[p] += xi;
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// welch psd: hann window, 50% overlap
+
+struct welch {
+	double psd[NBINS];	// accumulated power
+	double win[NFFT];	// window
+	double wss;		// window sum of squares
+	double buf[NFFT];	// input buffer
+	size_t n;		// samples in the buffer
+	size_t frames;		// frames accumulated
+};
+
+static void welch_init(struct welch *w) {
+	memset(w, 0, sizeof(struct welch));
+	for (size_t i = 0; i < NFFT; i++) {
+		w->win[i] = 0.5 - 0.5 * cos(2.0 * M_PI * (double)i / (double)NFFT);
+		w->wss += w->win[i] * w->win[i];
+	}
+}
+
+static void welch_frame(struct welch *w) {
+	static double re[NFFT], im[NFFT];
+	for (size_t i = 0; i < NFFT; i++) {
+		re[i] = w->buf[i] * w->win[i];
+		im[i] = 0.0;
+	}
+	fft(re, im, NFFT);
+	for (size_t i = 0; i < NBINS; i++) {
+		// one sided density (per Hz)
+		double p = (re[i] * re[i] + im[i] * im[i]) / (w->wss * (double)SAMPLERATE);
+		w->psd[i] += (i == 0 || i == NFFT / 2) ? p : 2.0 * p;
+	}
+	w->frames++;
+}
+
+// add a block of q5.27 samples
+static void welch_add(struct welch *w, const int32_t * x, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		w->buf[w->n++] = (double)x[i] * (1.0 / (double)(1 << 27));
+		if (w->n == NFFT) {
+			welch_frame(w);
+			// 50% overlap
+			memmove(w->buf, &w->buf[NFFT / 2], (NFFT / 2) * sizeof(double));
+			w->n = NFFT / 2;
+		}
+	}
+}
+
+// return the psd (dB) of bin i
+static double welch_db(const struct welch *w, size_t i) {
+	return 10.0 * log10(w->psd[i] / (double)w->frames + 1e-30);
+}
+
+// return the bin frequency
+static double bin_freq(size_t i) {
+	return (double)i * (double)SAMPLERATE / (double)NFFT;
+}
+
+// return the average psd (dB) for the band [f0, f1)
+static double welch_band_db(const struct welch *w, double f0, double f1) {
+	double sum = 0.0;
+	size_t n = 0;
+	for (size_t i = 1; i < NBINS; i++) {
+		double f = bin_freq(i);
+		if (f >= f0 && f < f1) {
+			sum += w->psd[i];
+			n++;
+		}
+	}
+	if (n == 0) {
+		// narrower than a bin: use the nearest bin to the band center
+		size_t i = (size_t)(sqrt(f0 * f1) * (double)NFFT / (double)SAMPLERATE + 0.5);
+		return welch_db(w, (i < NBINS) ? i : NBINS - 1);
+	}
+	return 10.0 * log10(sum / ((double)n * (double)w->frames) + 1e-30);
+}
+
+//-----------------------------------------------------------------------------
+// generators
+
+typedef void (*noise_func) (struct noise_state * s, int32_t * out);
+
+// run a generator and accumulate its psd
+static void run_generator(struct welch *w, noise_func f, uint32_t seed, size_t samples) {
+	struct noise_state s;
+	int32_t out[BUFSIZE];
+	noise_init(&s, seed);
+	welch_init(w);
+	for (size_t i = 0; i < samples; i += BUFSIZE) {
+		f(&s, out);
+		welch_add(w, out, BUFSIZE);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// float versus fixed point checks
+
+struct check {
+	const char *name;
+	noise_func ref;		// float version
+	noise_func dut;		// fixed point version
+};
+
+static const struct check checks[] = {
+	{"brown_noise", brown_noise, brown_noise_q31},
+	{"pink_noise1", pink_noise1, pink_noise1_q31},
+	{"pink_noise2", pink_noise2, pink_noise2_q31},
+};
+
+#define NUM_CHECKS (sizeof(checks) / sizeof(struct check))
+
+static struct welch w_ref, w_dut;
+
+// compare the 1/3 octave band levels, return the worst case difference (dB)
+static double band_compare(const struct welch *a, const struct welch *b) {
+	double worst = 0.0;
+	for (double fc = 20.0; fc < 20000.0; fc *= pow(2.0, 1.0 / 3.0)) {
+		double f0 = fc * pow(2.0, -1.0 / 6.0);
+		double f1 = fc * pow(2.0, 1.0 / 6.0);
+		double d = fabs(welch_band_db(a, f0, f1) - welch_band_db(b, f0, f1));
+		worst = (d > worst) ? d : worst;
+	}
+	return worst;
+}
+
+static int check_fixed(size_t samples) {
+	int fail = 0;
+	for (size_t i = 0; i < NUM_CHECKS; i++) {
+		const struct check *c = &checks[i];
+		run_generator(&w_ref, c->ref, 1, samples);
+		run_generator(&w_dut, c->dut, 1, samples);
+		double worst = band_compare(&w_ref, &w_dut);
+		int ok = worst <= CHECK_TOLERANCE;
+		printf("%-12s float vs fixed: max band difference %.4f dB %s\n", c->name, worst, ok ? "ok" : "FAIL");
+		fail |= !ok;
+	}
+	return fail;
+}
+
+//-----------------------------------------------------------------------------
+// velvet noise checks
+
+static const int32_t velvet_densities[] = {
+	VELVET_DENSITY_MIN, 2000, 7000, 20000, VELVET_DENSITY_MAX,
+};
+
+#define NUM_VELVET_DENSITIES (sizeof(velvet_densities) / sizeof(int32_t))
+
+static struct velvet_state check_vs;
+
+// check the dense and sparse velvet outputs agree and impulses don't overlap
+static int check_velvet(size_t samples) {
+	int fail = 0;
+	for (size_t i = 0; i < NUM_VELVET_DENSITIES; i++) {
+		int32_t density = velvet_densities[i];
+		const struct velvet_sparse *sp = &check_vs.sparse;
+		int32_t out[BUFSIZE];
+		size_t impulses = 0, over = 0, repeats = 0, mismatch = 0;
+		velvet_init(&check_vs, 1);
+		for (size_t j = 0; j < samples; j += BUFSIZE) {
+			velvet_noise(&check_vs, density, out);
+			int n = 0;
+			for (size_t k = 0; k < BUFSIZE; k++) {
+				over += (out[k] > VELVET_AMPLITUDE) || (out[k] < -VELVET_AMPLITUDE);
+				n += (out[k] != 0);
+			}
+			for (int k = 0; k < sp->n; k++) {
+				repeats += (k > 0) && (sp->pos[k] <= sp->pos[k - 1]);
+				mismatch += (out[sp->pos[k]] != sp->sign[k] * VELVET_AMPLITUDE);
+			}
+			mismatch += (n != sp->n);
+			impulses += sp->n;
+		}
+		int ok = (over == 0) && (repeats == 0) && (mismatch == 0);
+		printf("velvet %5d/s: %zu impulses, %zu over full scale, %zu repeated positions, %zu dense/sparse mismatches %s\n", density, impulses, over, repeats, mismatch, ok ? "ok" : "FAIL");
+		fail |= !ok;
+	}
+	return fail;
+}
+
+//-----------------------------------------------------------------------------
+// goom blep checks
+
+static struct goom_state check_goom;
+
+// check the goom blep corner corrections don't push the output past full scale
+static int check_goom_blep(void) {
+	const int32_t zero[BUFSIZE] = { 0 };
+	int32_t out[BUFSIZE];
+	double worst = 0.0;
+	int worst_pitch = 0, worst_duty = 0, worst_slope = 0;
+	for (int pitch = -64; pitch <= 64; pitch += 2) {
+		for (int duty = 0; duty < 128; duty += (duty == 126) ? 1 : 9) {
+			for (int slope = 0; slope < 128; slope += (slope == 126) ? 1 : 9) {
+				goom_init(&check_goom);
+				for (int i = 0; i < GOOM_CHECK_BLOCKS; i++) {
+					goom_blep_krate(&check_goom, pitch << 21, zero, zero, duty, slope, out);
+					for (size_t j = 0; j < BUFSIZE; j++) {
+						double peak = fabs((double)out[j]) / (double)goom_tables.f1;
+						if (peak > worst) {
+							worst = peak;
+							worst_pitch = pitch;
+							worst_duty = duty;
+							worst_slope = slope;
+						}
+					}
+				}
+			}
+		}
+	}
+	int ok = worst <= GOOM_CHECK_PEAK;
+	printf("goom blep: peak %.3f of full scale (pitch %d duty %d slope %d) %s\n", worst, worst_pitch, worst_duty, worst_slope, ok ? "ok" : "FAIL");
+	return !ok;
+}
+
+//-----------------------------------------------------------------------------
+// accuracy versus cost evaluation
+
+static struct noise_state eval_noise;
+static struct voss_state eval_voss;
+static struct tilt_state eval_tilt;
+static struct velvet_state eval_vs;
+
+static void eval_noise_init(void) {
+	noise_init(&eval_noise, 1);
+}
+
+static void eval_voss_init(void) {
+	voss_init(&eval_voss, 1);
+}
+
+static void eval_tilt_init(void) {
+	tilt_init(&eval_tilt, 1);
+}
+
+static void eval_velvet_init(void) {
+	velvet_init(&eval_vs, 1);
+}
+
+static void eval_white(int32_t * out) {
+	white_noise(&eval_noise, out);
+}
+
+static void eval_brown(int32_t * out) {
+	brown_noise(&eval_noise, out);
+}
+
+static void eval_pink1(int32_t * out) {
+	pink_noise1(&eval_noise, out);
+}
+
+static void eval_pink2(int32_t * out) {
+	pink_noise2(&eval_noise, out);
+}
+
+static void eval_brown_q31(int32_t * out) {
+	brown_noise_q31(&eval_noise, out);
+}
+
+static void eval_pink1_q31(int32_t * out) {
+	pink_noise1_q31(&eval_noise, out);
+}
+
+static void eval_pink2_q31(int32_t * out) {
+	pink_noise2_q31(&eval_noise, out);
+}
+
+static void eval_pink3(int32_t * out) {
+	pink_noise3(&eval_voss, out);
+}
+
+static void eval_tilt0(int32_t * out) {
+	tilt_noise(&eval_tilt, 0, out);
+}
+
+static void eval_tilt1(int32_t * out) {
+	tilt_noise(&eval_tilt, 1 << 26, out);
+}
+
+static void eval_tilt2(int32_t * out) {
+	tilt_noise(&eval_tilt, (1 << 27) - 1, out);
+}
+
+static void eval_velvet(int32_t * out) {
+	velvet_noise(&eval_vs, 2000, out);
+}
+
+struct eval {
+	const char *name;
+	double ideal;		// ideal slope (dB/octave)
+	void (*init)(void);
+	void (*run)(int32_t * out);
+};
+
+static const struct eval evals[] = {
+	{"white_noise", 0.0, eval_noise_init, eval_white},
+	{"brown_noise", -6.0, eval_noise_init, eval_brown},
+	{"brown_noise_q31", -6.0, eval_noise_init, eval_brown_q31},
+	{"pink_noise1", -3.0, eval_noise_init, eval_pink1},
+	{"pink_noise1_q31", -3.0, eval_noise_init, eval_pink1_q31},
+	{"pink_noise2", -3.0, eval_noise_init, eval_pink2},
+	{"pink_noise2_q31", -3.0, eval_noise_init, eval_pink2_q31},
+	{"pink_noise3", -3.0, eval_voss_init, eval_pink3},
+	{"tilt_noise(0)", 0.0, eval_tilt_init, eval_tilt0},
+	{"tilt_noise(1)", -3.0, eval_tilt_init, eval_tilt1},
+	{"tilt_noise(2)", -6.0, eval_tilt_init, eval_tilt2},
+	{"velvet_noise", 0.0, eval_velvet_init, eval_velvet},
+};
+
+#define NUM_EVALS (sizeof(evals) / sizeof(struct eval))
+
+struct eval_result {
+	double slope;		// fitted slope (dB/octave)
+	double max_dev;		// maximum band deviation from the ideal slope (dB)
+	double rms_dev;		// rms band deviation from the ideal slope (dB)
+	double ns;		// ns/sample
+	double cycles;		// tsc cycles/sample (0 if not available)
+};
+
+static double now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+static void run_eval(const struct eval *e, int32_t * buf, size_t samples, struct eval_result *r) {
+	// time the generator
+	e->init();
+	double t0 = now_ns();
+	uint64_t c0 = now_cycles();
+	for (size_t i = 0; i < samples; i += BUFSIZE) {
+		e->run(&buf[i]);
+	}
+	r->cycles = (double)(now_cycles() - c0) / (double)samples;
+	r->ns = (now_ns() - t0) / (double)samples;
+	// psd
+	welch_init(&w_ref);
+	welch_add(&w_ref, buf, samples);
+	// least squares fit of the band levels to a line in log2(f)
+	double x[64], y[64];
+	size_t n = 0;
+	for (double fc = EVAL_FMIN; fc <= EVAL_FMAX && n < 64; fc *= pow(2.0, 1.0 / 3.0)) {
+		x[n] = log2(fc);
+		y[n] = welch_band_db(&w_ref, fc * pow(2.0, -1.0 / 6.0), fc * pow(2.0, 1.0 / 6.0));
+		n++;
+	}
+	double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		sx += x[i];
+		sy += y[i];
+		sxx += x[i] * x[i];
+		sxy += x[i] * y[i];
+	}
+	r->slope = ((double)n * sxy - sx * sy) / ((double)n * sxx - sx * sx);
+	// deviation from the ideal slope (with the best fit offset)
+	double ofs = (sy - e->ideal * sx) / (double)n;
+	double sum = 0.0;
+	r->max_dev = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		double d = y[i] - (ofs + e->ideal * x[i]);
+		sum += d * d;
+		r->max_dev = (fabs(d) > r->max_dev) ? fabs(d) : r->max_dev;
+	}
+	r->rms_dev = sqrt(sum / (double)n);
+}
+
+static int eval_all(size_t samples, const char *csv) {
+	int32_t *buf = (int32_t *) malloc(samples * sizeof(int32_t));
+	if (buf == NULL) {
+		printf("out of memory\n");
+		return 1;
+	}
+	FILE *f = NULL;
+	if (csv != NULL) {
+		f = fopen(csv, "w");
+		if (f == NULL) {
+			printf("can't open %s\n", csv);
+			free(buf);
+			return 1;
+		}
+		fprintf(f, "name,ideal_db_oct,slope_db_oct,slope_error_db_oct,max_dev_db,rms_dev_db,ns_per_sample,cycles_per_sample\n");
+	}
+	printf("%d samples, slope fit %.0f..%.0f Hz (1/3 octave bands)\n", (int)samples, EVAL_FMIN, EVAL_FMAX);
+	printf("%-16s %7s %7s %7s %8s %8s %8s %8s\n", "generator", "ideal", "slope", "error", "max dev", "rms dev", "ns/smp", "cyc/smp");
+	for (size_t i = 0; i < NUM_EVALS; i++) {
+		const struct eval *e = &evals[i];
+		struct eval_result r;
+		run_eval(e, buf, samples, &r);
+		printf("%-16s %7.2f %7.2f %+7.2f %8.2f %8.2f %8.2f %8.2f\n", e->name, e->ideal, r.slope, r.slope - e->ideal, r.max_dev, r.rms_dev, r.ns, r.cycles);
+		if (f != NULL) {
+			fprintf(f, "%s,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", e->name, e->ideal, r.slope, r.slope - e->ideal, r.max_dev, r.rms_dev, r.ns, r.cycles);
+		}
+	}
+	if (f != NULL) {
+		fclose(f);
+		printf("wrote %s\n", csv);
+	}
+	free(buf);
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+
+// return the sample count argument rounded down to whole blocks (0 if too small)
+static size_t get_samples(int argc, char *argv[], size_t dflt) {
+	size_t samples = (argc > 2) ? (size_t)strtoul(argv[2], NULL, 0) : dflt;
+	samples -= samples % BUFSIZE;
+	if (samples < NFFT) {
+		printf("samples must be at least %d\n", NFFT);
+		return 0;
+	}
+	return samples;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		printf("usage: %s check|eval [samples] [csv]\n", argv[0]);
+		return 1;
+	}
+	shim_init();
+	if (strcmp(argv[1], "check") == 0) {
+		size_t samples = get_samples(argc, argv, CHECK_SAMPLES);
+		if (samples == 0) {
+			return 1;
+		}
+		int fail = check_fixed(samples);
+		fail |= check_velvet(samples);
+		fail |= check_goom_blep();
+		return fail ? 1 : 0;
+	}
+	if (strcmp(argv[1], "eval") == 0) {
+		size_t samples = get_samples(argc, argv, EVAL_SAMPLES);
+		if (samples == 0) {
+			return 1;
+		}
+		return eval_all(samples, (argc > 3) ? argv[3] : NULL);
+	}
+	printf("unknown mode: %s\n", argv[1]);
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
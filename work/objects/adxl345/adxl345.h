@@ -14,6 +14,10 @@ http://www.analog.com/media/en/technical-documentation/data-sheets/ADXL345.pdf
 
 //-----------------------------------------------------------------------------
 
+#include "../dsp/dsp.h"
+
+//-----------------------------------------------------------------------------
+
 #if CH_KERNEL_MAJOR == 2
 #define THD_WORKING_AREA_SIZE THD_WA_SIZE
 #define MSG_OK RDY_OK
@@ -91,14 +95,6 @@ struct adxl345_state {
 
 //-----------------------------------------------------------------------------
 
-// convert a float to q11.21
-static int32_t float_to_q21(float f) {
-	__ASM volatile ("VCVT.S32.F32 %0, %0, 21":"+w" (f));
-	return *(int32_t *) (&f);
-}
-
-//-----------------------------------------------------------------------------
-
 // Allocate a 32-bit aligned buffer of size bytes from sram2.
 // The memory pool is big enough for 2 concurrent devices.
 static void *adxl345_malloc(size_t size) {
@@ -152,9 +148,9 @@ static int adxl345_rd_accel(struct adxl345_state *s) {
 		return -1;
 	}
 
-	float x = (float)((int16_t) ((s->rx[1] << 8) | s->rx[0])) * ADXL345_SCALE;
-	float y = (float)((int16_t) ((s->rx[3] << 8) | s->rx[2])) * ADXL345_SCALE;
-	float z = (float)((int16_t) ((s->rx[5] << 8) | s->rx[4])) * ADXL345_SCALE;
+	float x = (float)dsp_le16(&s->rx[0]) * ADXL345_SCALE;
+	float y = (float)dsp_le16(&s->rx[2]) * ADXL345_SCALE;
+	float z = (float)dsp_le16(&s->rx[4]) * ADXL345_SCALE;
 
 	// copy to the shared variables
 	chSysLock();
@@ -259,9 +255,10 @@ static void adxl345_krate(struct adxl345_state *s, int32_t * xi, int32_t * yi, i
 	z = s->z;
 	chSysUnlock();
 
-	*xi = (int32_t) (x * 32.f);	//float_to_q27(x);
-	*yi = (int32_t) (y * 32.f);	//float_to_q27(y);
-	*zi = (int32_t) (z * 32.f);	//float_to_q27(z);
+	// 1/32 g units
+	*xi = dsp_float_to_q(x, 5);
+	*yi = dsp_float_to_q(y, 5);
+	*zi = dsp_float_to_q(z, 5);
 }
 
 //-----------------------------------------------------------------------------
@@ -0,0 +1,207 @@
+//-----------------------------------------------------------------------------
+/*
+
+DSP Primitives
+
+Saturating arithmetic, multiply-accumulates, fixed/float conversions and
+sensor data conversions for the DSP kernels and drivers in work/objects.
+
+On the Cortex-M4F (DSP_M4) these map to the DSP/FPU instructions
+(QADD, QSUB, REVSH, VCVT). Elsewhere (host builds, see
+work/bench) they are plain C with the same results, so the kernels built on
+them can be checked and benchmarked on the host.
+
+The 32x32->64 multiplies are written in C on both: gcc emits SMULL/SMLAL for
+them on the M4.
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef DEADSY_DSP_H
+#define DEADSY_DSP_H
+
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#ifndef DSP_INLINE
+#define DSP_INLINE static inline __attribute__((always_inline))
+#endif
+
+// Cortex-M4 with the DSP extension and single precision FPU
+#if defined(__ARM_FEATURE_DSP) && defined(__ARM_FP)
+#define DSP_M4 1
+#else
+#define DSP_M4 0
+#endif
+
+//-----------------------------------------------------------------------------
+// saturating add/subtract
+
+#if DSP_M4
+
+// a + b, saturated to the int32_t range (QADD)
+DSP_INLINE int32_t dsp_qadd(int32_t a, int32_t b) {
+	int32_t r;
+	__ASM("qadd %0, %1, %2":"=r" (r):"r"(a), "r"(b));
+	return r;
+}
+
+// a - b, saturated to the int32_t range (QSUB)
+DSP_INLINE int32_t dsp_qsub(int32_t a, int32_t b) {
+	int32_t r;
+	__ASM("qsub %0, %1, %2":"=r" (r):"r"(a), "r"(b));
+	return r;
+}
+
+#else
+
+// saturate a 64 bit value to the int32_t range
+DSP_INLINE int32_t dsp_sat32(int64_t x) {
+	if (x > INT32_MAX) {
+		return INT32_MAX;
+	}
+	if (x < INT32_MIN) {
+		return INT32_MIN;
+	}
+	return (int32_t) x;
+}
+
+DSP_INLINE int32_t dsp_qadd(int32_t a, int32_t b) {
+	return dsp_sat32((int64_t) a + b);
+}
+
+DSP_INLINE int32_t dsp_qsub(int32_t a, int32_t b) {
+	return dsp_sat32((int64_t) a - b);
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+// multiply-accumulates
+
+// acc + a * b, 32x32->64 (SMLAL)
+DSP_INLINE int64_t dsp_smlal(int64_t acc, int32_t a, int32_t b) {
+	return acc + (int64_t) a *b;
+}
+
+// a * x, rounded to q.31 scaling (SMULL)
+DSP_INLINE int32_t dsp_mul_q31(int32_t a, int32_t x) {
+	int64_t acc = dsp_smlal(1LL << 30, a, x);
+	return (int32_t) (acc >> 31);
+}
+
+// a * x + b * y, rounded to q.31 scaling (SMULL/SMLAL)
+DSP_INLINE int32_t dsp_mac_q31(int32_t a, int32_t x, int32_t b, int32_t y) {
+	int64_t acc = dsp_smlal(dsp_smlal(1LL << 30, a, x), b, y);
+	return (int32_t) (acc >> 31);
+}
+
+//-----------------------------------------------------------------------------
+// fixed/float conversions
+// float to fixed rounds towards zero and saturates (as per VCVT.S32.F32)
+
+#if DSP_M4
+
+union dsp_f32 {
+	float f;
+	int32_t i;
+};
+
+// float to q11.21
+DSP_INLINE int32_t dsp_float_to_q21(float f) {
+	union dsp_f32 x = {.f = f };
+	__ASM("vcvt.s32.f32 %0, %0, #21":"+w" (x.f));
+	return x.i;
+}
+
+// float to q5.27
+DSP_INLINE int32_t dsp_float_to_q27(float f) {
+	union dsp_f32 x = {.f = f };
+	__ASM("vcvt.s32.f32 %0, %0, #27":"+w" (x.f));
+	return x.i;
+}
+
+// q5.27 to float
+DSP_INLINE float dsp_q27_to_float(int32_t i) {
+	union dsp_f32 x = {.i = i };
+	__ASM("vcvt.f32.s32 %0, %0, #27":"+w" (x.f));
+	return x.f;
+}
+
+// q1.31 to float
+DSP_INLINE float dsp_q31_to_float(int32_t i) {
+	union dsp_f32 x = {.i = i };
+	__ASM("vcvt.f32.s32 %0, %0, #31":"+w" (x.f));
+	return x.f;
+}
+
+// float to q(32-bits).bits
+DSP_INLINE int32_t dsp_float_to_q(float f, int bits) {
+	union dsp_f32 x = {.f = f * (float)(1U << bits) };
+	__ASM("vcvt.s32.f32 %0, %0":"+w" (x.f));
+	return x.i;
+}
+
+#else
+
+// float to q(32-bits).bits
+DSP_INLINE int32_t dsp_float_to_q(float f, int bits) {
+	float x = f * (float)(1U << bits);
+	if (x >= 2147483647.f) {
+		return INT32_MAX;
+	}
+	if (x <= -2147483648.f) {
+		return INT32_MIN;
+	}
+	return (int32_t) x;
+}
+
+DSP_INLINE int32_t dsp_float_to_q21(float f) {
+	return dsp_float_to_q(f, 21);
+}
+
+DSP_INLINE int32_t dsp_float_to_q27(float f) {
+	return dsp_float_to_q(f, 27);
+}
+
+DSP_INLINE float dsp_q27_to_float(int32_t i) {
+	return (float)i * (1.f / (float)(1 << 27));
+}
+
+DSP_INLINE float dsp_q31_to_float(int32_t i) {
+	return (float)i * (1.f / 2147483648.f);
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+// sensor data conversions
+
+#if DSP_M4
+
+// big endian 16 bit register value to int32_t (REVSH)
+DSP_INLINE int32_t dsp_be16(const uint8_t * p) {
+	int32_t r;
+	__ASM("revsh %0, %1":"=r" (r):"r"(*(const uint16_t *)p));
+	return r;
+}
+
+#else
+
+DSP_INLINE int32_t dsp_be16(const uint8_t * p) {
+	return (int16_t) ((p[0] << 8) | p[1]);
+}
+
+#endif
+
+// little endian 16 bit register value to int32_t
+DSP_INLINE int32_t dsp_le16(const uint8_t * p) {
+	return (int16_t) ((p[1] << 8) | p[0]);
+}
+
+//-----------------------------------------------------------------------------
+
+#endif				// DEADSY_DSP_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,180 @@
+//-----------------------------------------------------------------------------
+/*
+
+K-rate Profiler
+
+Opt-in timing of the k-rate code of each object instance. Objects wrap their
+k-rate code with prof_start/prof_stop. Build with PROF_ENABLE defined as 1
+to turn it on, otherwise the calls compile to nothing.
+
+Each instance keeps the min/mean/max block time and a log scale histogram
+(4 bins per octave) used to estimate the 99th percentile. The results are
+logged (LogTextMessage) and reset every PROF_PERIOD blocks. The report phase
+of each instance is offset by PROF_STAGGER blocks, so a large patch logs one
+instance at a time rather than all of them in the same k-rate tick.
+
+Times are in cpu cycles (DWT CYCCNT) on the target and in ns on the host.
+The budget figure is the p99 time as a percentage of a k-rate period.
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef DEADSY_PROF_H
+#define DEADSY_PROF_H
+
+//-----------------------------------------------------------------------------
+
+#include "dsp.h"
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 0
+#endif
+
+//-----------------------------------------------------------------------------
+
+#if PROF_ENABLE
+
+#define PROF_BINS 80		// histogram bins: up to 2^21 cycles/ns per block
+#define PROF_PERIOD (SAMPLERATE / BUFSIZE)	// blocks per report (1 second)
+#define PROF_STAGGER 7		// blocks between the reports of successive instances
+
+#if DSP_M4
+
+#ifndef PROF_CLOCK
+#define PROF_CLOCK 168000000	// cpu clock (Hz)
+#endif
+
+static void prof_timer_init(void) {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static inline uint32_t prof_now(void) {
+	return DWT->CYCCNT;
+}
+
+#else
+
+#include <time.h>
+
+#define PROF_CLOCK 1000000000	// ns
+
+static void prof_timer_init(void) {
+}
+
+static inline uint32_t prof_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t) ts.tv_sec * 1000000000U + (uint32_t) ts.tv_nsec;
+}
+
+#endif
+
+// time per k-rate period
+#define PROF_BUDGET ((uint32_t)((uint64_t)PROF_CLOCK * BUFSIZE / SAMPLERATE))
+
+struct prof_state {
+	const char *name;	// instance name
+	uint32_t t0;		// start time
+	uint32_t n;		// blocks in this period
+	uint32_t report;	// blocks until the next report
+	uint32_t min, max;	// min/max block time
+	uint64_t sum;		// total block time
+	uint16_t hist[PROF_BINS];	// histogram of block times
+};
+
+// return the histogram bin for a time
+static inline uint32_t prof_bin(uint32_t t) {
+	if (t < 4) {
+		return t;
+	}
+	uint32_t l = 31 - __builtin_clz(t);
+	uint32_t b = (4 * (l - 1)) + ((t >> (l - 2)) & 3);
+	return (b < PROF_BINS) ? b : PROF_BINS - 1;
+}
+
+// return the lower bound of the times in a histogram bin
+static uint32_t prof_bin_time(uint32_t b) {
+	if (b < 4) {
+		return b;
+	}
+	return (4 + (b & 3)) << ((b >> 2) - 1);
+}
+
+static void prof_reset(struct prof_state *p) {
+	p->n = 0;
+	p->min = UINT32_MAX;
+	p->max = 0;
+	p->sum = 0;
+	memset(p->hist, 0, sizeof(p->hist));
+}
+
+static void prof_init(struct prof_state *p, const char *name) {
+	static uint32_t instances = 0;
+	prof_timer_init();
+	p->name = name;
+	prof_reset(p);
+	// the first period is stretched to set the report phase
+	p->report = PROF_PERIOD + ((instances * PROF_STAGGER) % PROF_PERIOD);
+	instances++;
+}
+
+// return the 99th percentile (the upper bound of the bin it falls in)
+static uint32_t prof_p99(struct prof_state *p) {
+	uint32_t limit = p->n - (p->n / 100);
+	uint32_t count = 0;
+	for (uint32_t b = 0; b < PROF_BINS - 1; b++) {
+		count += p->hist[b];
+		if (count >= limit) {
+			return prof_bin_time(b + 1);
+		}
+	}
+	return p->max;
+}
+
+static void prof_report(struct prof_state *p) {
+	uint32_t p99 = prof_p99(p);
+	uint32_t pct = (uint32_t) (((uint64_t) p99 * 10000) / PROF_BUDGET);
+	LogTextMessage("%s: min %u mean %u max %u p99 %u (%u.%02u%%)", p->name, p->min, (uint32_t) (p->sum / p->n), p->max, p99, pct / 100, pct % 100);
+}
+
+static inline void prof_start(struct prof_state *p) {
+	p->t0 = prof_now();
+}
+
+static inline void prof_stop(struct prof_state *p) {
+	uint32_t t = prof_now() - p->t0;
+	p->min = (t < p->min) ? t : p->min;
+	p->max = (t > p->max) ? t : p->max;
+	p->sum += t;
+	p->hist[prof_bin(t)] += 1;
+	p->n += 1;
+	p->report -= 1;
+	if (p->report == 0) {
+		prof_report(p);
+		prof_reset(p);
+		p->report = PROF_PERIOD;
+	}
+}
+
+#else
+
+struct prof_state {
+};
+
+static inline void prof_init(struct prof_state *p, const char *name) {
+}
+
+static inline void prof_start(struct prof_state *p) {
+}
+
+static inline void prof_stop(struct prof_state *p) {
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+
+#endif				// DEADSY_PROF_H
+
+//-----------------------------------------------------------------------------
@@ -12,6 +12,10 @@ Author: Jason Harris (https://github.com/deadsy)
 
 //-----------------------------------------------------------------------------
 
+#include "../dsp/dsp.h"
+
+//-----------------------------------------------------------------------------
+
 #if CH_KERNEL_MAJOR == 2
 #define THD_WORKING_AREA_SIZE THD_WA_SIZE
 #define MSG_OK RDY_OK
@@ -123,10 +127,11 @@ static int hmc5883l_rd_compass(struct hmc5883l_state *s) {
 		return -1;
 	}
 	// TODO unit conversion
+	// The data registers are big endian, in X, Z, Y order.
 	chSysLock();
-	s->x = *(uint16_t *) & s->rx[0];
-	s->y = *(uint16_t *) & s->rx[2];
-	s->z = *(uint16_t *) & s->rx[4];
+	s->x = dsp_be16(&s->rx[0]);
+	s->z = dsp_be16(&s->rx[2]);
+	s->y = dsp_be16(&s->rx[4]);
 	chSysUnlock();
 
 	return 0;
@@ -3,6 +3,22 @@
 
 Autoharp Strummer
 
+The events inlet takes the key events from a key matrix (see sx1509/key).
+Each one is passed to strum_key before the k-rate tick. The keys are the
+chord bars: each row of the matrix is a chord shape and each column is a root
+note (on the circle of fifths). With no chord key held the strings play the
+open (drone) tuning.
+
+The touch inlet has a bit per string. A string is plucked (note on) when its
+touch bit is set and damped (note off) when it is cleared. Only the changed
+bits are visited on each k-rate tick.
+
+The notes for each (root, chord shape) are in a const table (flash), so a
+chord change is a pointer update.
+
+Notes are sent with MidiSend3. The note/gate outlets give the last plucked
+note and whether any string is sounding.
+
 */
 //-----------------------------------------------------------------------------
 
@@ -13,20 +29,33 @@ Autoharp Strummer
 
 #define STRUM_SIZE 16
 
+// key events (as per sx1509/key)
+#define STRUM_EVENT_KEYDN 1
+#define STRUM_EVENT_KEYUP 2
+
 //-----------------------------------------------------------------------------
 
 // strum configuration
 struct strum_cfg {
 	int touch_bits;		// number of touch bits
+	midi_device_t device;	// midi output device
+	uint8_t port;		// midi output port
+	uint8_t channel;	// midi channel 0..15
+	uint8_t base;		// note for the lowest string of a C chord
+	uint8_t velocity;	// note on velocity
 };
 
 // strum state variables
 struct strum_state {
+	const struct strum_cfg *cfg;	// configuration
 	uint32_t touch_mask;
+	uint32_t touch;		// current touch bits
+	int key;		// current chord key (-1 for none)
 	int root;		// current root note
 	int chord;		// current chord shape
-	uint8_t notes[STRUM_SIZE];	// current strum notes to be played
-	uint8_t drone[STRUM_SIZE];	// current drone notes to be played
+	int32_t note;		// last plucked note (outlet)
+	const uint8_t *notes;	// current strum notes to be played
+	uint8_t playing[STRUM_SIZE];	// the note sounding on each string
 };
 
 //-----------------------------------------------------------------------------
@@ -46,6 +75,7 @@ enum {
 	ROOT_A,
 	ROOT_A_SHARP,
 	ROOT_B,
+	ROOT_MAX,
 };
 
 // chord shapes
@@ -58,6 +88,65 @@ enum {
 	CHORD_MIN7,
 	CHORD_AUG,
 	CHORD_DIM,
+	CHORD_MAX,
+};
+
+//-----------------------------------------------------------------------------
+// chord tables
+
+// key matrix: the row selects the chord shape, the column selects the root
+#define STRUM_KEY_ROWS 8
+#define STRUM_KEY_COLS 8
+
+static const uint8_t strum_key_chord[STRUM_KEY_ROWS] = {
+	CHORD_MAJ, CHORD_MIN, CHORD_DOM7, CHORD_MAJ7, CHORD_MIN7, CHORD_AUG, CHORD_DIM, CHORD_NONE,
+};
+
+static const uint8_t strum_key_root[STRUM_KEY_COLS] = {
+	ROOT_D_SHARP, ROOT_A_SHARP, ROOT_F, ROOT_C, ROOT_G, ROOT_D, ROOT_A, ROOT_E,
+};
+
+// Strum notes (semitones above the base note) for each root and chord shape.
+// The chord notes (intervals above the root) repeat up the strings an octave
+// at a time. Without a root or chord shape the strings have the open (drone)
+// tuning: a diatonic major scale.
+
+#define STRUM_3(r, a, b, c) { \
+	(r)+(a), (r)+(b), (r)+(c), (r)+12+(a), (r)+12+(b), (r)+12+(c), \
+	(r)+24+(a), (r)+24+(b), (r)+24+(c), (r)+36+(a), (r)+36+(b), (r)+36+(c), \
+	(r)+48+(a), (r)+48+(b), (r)+48+(c), (r)+60+(a) }
+
+#define STRUM_4(r, a, b, c, d) { \
+	(r)+(a), (r)+(b), (r)+(c), (r)+(d), (r)+12+(a), (r)+12+(b), (r)+12+(c), (r)+12+(d), \
+	(r)+24+(a), (r)+24+(b), (r)+24+(c), (r)+24+(d), (r)+36+(a), (r)+36+(b), (r)+36+(c), (r)+36+(d) }
+
+#define STRUM_DRONE { 0, 2, 4, 5, 7, 9, 11, 12, 14, 16, 17, 19, 21, 23, 24, 26 }
+
+#define STRUM_ROOT(r) { \
+	STRUM_DRONE,		/* CHORD_NONE */ \
+	STRUM_3(r, 0, 4, 7),	/* CHORD_MAJ */ \
+	STRUM_3(r, 0, 3, 7),	/* CHORD_MIN */ \
+	STRUM_4(r, 0, 4, 7, 10),	/* CHORD_DOM7 */ \
+	STRUM_4(r, 0, 4, 7, 11),	/* CHORD_MAJ7 */ \
+	STRUM_4(r, 0, 3, 7, 10),	/* CHORD_MIN7 */ \
+	STRUM_3(r, 0, 4, 8),	/* CHORD_AUG */ \
+	STRUM_3(r, 0, 3, 6),	/* CHORD_DIM */ \
+}
+
+static const uint8_t strum_notes[ROOT_MAX][CHORD_MAX][STRUM_SIZE] = {
+	{STRUM_DRONE, STRUM_DRONE, STRUM_DRONE, STRUM_DRONE, STRUM_DRONE, STRUM_DRONE, STRUM_DRONE, STRUM_DRONE},	// ROOT_NONE
+	STRUM_ROOT(0),		// ROOT_C
+	STRUM_ROOT(1),		// ROOT_C_SHARP
+	STRUM_ROOT(2),		// ROOT_D
+	STRUM_ROOT(3),		// ROOT_D_SHARP
+	STRUM_ROOT(4),		// ROOT_E
+	STRUM_ROOT(5),		// ROOT_F
+	STRUM_ROOT(6),		// ROOT_F_SHARP
+	STRUM_ROOT(7),		// ROOT_G
+	STRUM_ROOT(8),		// ROOT_G_SHARP
+	STRUM_ROOT(9),		// ROOT_A
+	STRUM_ROOT(10),		// ROOT_A_SHARP
+	STRUM_ROOT(11),		// ROOT_B
 };
 
 //-----------------------------------------------------------------------------
@@ -65,13 +154,73 @@ enum {
 static void strum_init(struct strum_state *s, const struct strum_cfg *cfg) {
 	// initialise the state
 	memset(s, 0, sizeof(struct strum_state));
-	s->touch_mask = (1ULL << cfg->touch_bits) - 1;
+	s->cfg = cfg;
+	s->touch_mask = (1ULL << ((cfg->touch_bits < STRUM_SIZE) ? cfg->touch_bits : STRUM_SIZE)) - 1;
+	s->key = -1;
+	s->note = cfg->base;
+	s->notes = strum_notes[ROOT_NONE][CHORD_NONE];
 }
 
 //-----------------------------------------------------------------------------
 
-static void strum_krate(struct strum_state *s, int32_t key, int32_t touch) {
+// set the strum notes for a root and chord shape
+static void strum_set_chord(struct strum_state *s, int root, int chord) {
+	s->root = root;
+	s->chord = chord;
+	s->notes = strum_notes[root][chord];
+}
+
+// handle a key event
+static void strum_key(struct strum_state *s, int event, int key) {
+	if (key >= STRUM_KEY_ROWS * STRUM_KEY_COLS) {
+		return;
+	}
+	if (event == STRUM_EVENT_KEYDN) {
+		s->key = key;
+		strum_set_chord(s, strum_key_root[key % STRUM_KEY_COLS], strum_key_chord[key / STRUM_KEY_COLS]);
+	} else if (event == STRUM_EVENT_KEYUP && key == s->key) {
+		s->key = -1;
+		strum_set_chord(s, ROOT_NONE, CHORD_NONE);
+	}
+}
+
+static void strum_note_on(struct strum_state *s, int i) {
+	const struct strum_cfg *cfg = s->cfg;
+	int note = cfg->base + s->notes[i];
+	note = (note > 127) ? 127 : note;
+	s->playing[i] = note;
+	s->note = note;
+	MidiSend3(cfg->device, cfg->port, MIDI_NOTE_ON | cfg->channel, note, cfg->velocity);
+}
+
+static void strum_note_off(struct strum_state *s, int i) {
+	const struct strum_cfg *cfg = s->cfg;
+	MidiSend3(cfg->device, cfg->port, MIDI_NOTE_OFF | cfg->channel, s->playing[i], 0);
+}
+
+//-----------------------------------------------------------------------------
+
+static void strum_krate(struct strum_state *s,	// state
+			int32_t touch,	// inlet touch bits
+			int32_t * note,	// outlet q11.21 pitch
+			int32_t * gate	// outlet bool
+    ) {
+
 	touch &= s->touch_mask;
+	uint32_t changed = s->touch ^ (uint32_t) touch;
+	s->touch = touch;
+	while (changed) {
+		int i = __builtin_ctz(changed);
+		changed &= changed - 1;
+		if (touch & (1U << i)) {
+			strum_note_on(s, i);
+		} else {
+			strum_note_off(s, i);
+		}
+	}
+
+	*note = (s->note - 64) << 21;
+	*gate = (s->touch != 0);
 }
 
 //-----------------------------------------------------------------------------
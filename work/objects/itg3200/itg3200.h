@@ -14,6 +14,10 @@ https://www.invensense.com/wp-content/uploads/2015/02/ITG-3200-Datasheet.pdf
 
 //-----------------------------------------------------------------------------
 
+#include "../dsp/dsp.h"
+
+//-----------------------------------------------------------------------------
+
 #if CH_KERNEL_MAJOR == 2
 #define THD_WORKING_AREA_SIZE THD_WA_SIZE
 #define MSG_OK RDY_OK
@@ -127,10 +131,11 @@ static int itg3200_rd_gyro(struct itg3200_state *s) {
 		return -1;
 	}
 	// TODO unit conversion
+	// The data registers are big endian.
 	chSysLock();
-	s->x = *(uint16_t *) & s->rx[2];
-	s->y = *(uint16_t *) & s->rx[4];
-	s->z = *(uint16_t *) & s->rx[6];
+	s->x = dsp_be16(&s->rx[2]);
+	s->y = dsp_be16(&s->rx[4]);
+	s->z = dsp_be16(&s->rx[6]);
 	// TODO use temperature
 	chSysUnlock();
 
@@ -17,68 +17,340 @@ https://en.wikipedia.org/wiki/Brownian_noise
 
 //-----------------------------------------------------------------------------
 
-// convert a q1.31 to a float32
-static float q31_to_float(int32_t op1) {
-	float fop1 = *(float *)(&op1);
-	__ASM volatile ("VCVT.F32.S32 %0, %0, 31":"+w" (fop1));
-	return fop1;
+#include "../dsp/dsp.h"
+
+//-----------------------------------------------------------------------------
+
+// Kernels with an _n suffix take the block size as an argument. They are
+// always inlined, so the BUFSIZE wrappers (and other fixed size callers) get
+// a copy specialized for a constant size.
+// The random values are generated onto the stack, so blocks are processed in
+// chunks of up to NOISE_BLOCK_MAX samples. For a constant size up to
+// NOISE_BLOCK_MAX the chunk loop runs once and compiles away.
+
+#define NOISE_BLOCK_MAX 64
+
+// return the size of the next chunk of a block with n samples left
+static inline size_t noise_block_n(size_t n) {
+	return (n < NOISE_BLOCK_MAX) ? n : NOISE_BLOCK_MAX;
 }
 
-// return a float [-1, 1)
-static float rand_float(void) {
-	return q31_to_float(rand_s32());
+//-----------------------------------------------------------------------------
+
+// Per-instance random number generator: xoshiro128+
+// See: http://prng.di.unimi.it/
+// Each instance has its own (seedable, reproducible) stream. Streams are
+// spaced 2^64 values apart with the jump function, so they don't overlap.
+
+struct rng_state {
+	uint32_t s0, s1, s2, s3;
+};
+
+static inline uint32_t rng_rotl(uint32_t x, int k) {
+	return (x << k) | (x >> (32 - k));
+}
+
+// return the next 32 random bits
+static inline uint32_t rng_next(struct rng_state *r) {
+	uint32_t result = r->s0 + r->s3;
+	uint32_t t = r->s1 << 9;
+	r->s2 ^= r->s0;
+	r->s3 ^= r->s1;
+	r->s1 ^= r->s2;
+	r->s0 ^= r->s3;
+	r->s2 ^= t;
+	r->s3 = rng_rotl(r->s3, 11);
+	return result;
+}
+
+// advance the generator by 2^64 values
+static void rng_jump(struct rng_state *r) {
+	static const uint32_t jump[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+	uint32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	for (size_t i = 0; i < 4; i++) {
+		for (size_t b = 0; b < 32; b++) {
+			if (jump[i] & (1U << b)) {
+				s0 ^= r->s0;
+				s1 ^= r->s1;
+				s2 ^= r->s2;
+				s3 ^= r->s3;
+			}
+			rng_next(r);
+		}
+	}
+	r->s0 = s0;
+	r->s1 = s1;
+	r->s2 = s2;
+	r->s3 = s3;
+}
+
+// splitmix32 (used to expand a seed into the generator state)
+static uint32_t rng_splitmix(uint32_t * x) {
+	uint32_t z = (*x += 0x9e3779b9);
+	z = (z ^ (z >> 16)) * 0x85ebca6b;
+	z = (z ^ (z >> 13)) * 0xc2b2ae35;
+	return z ^ (z >> 16);
+}
+
+// Seed the generator. A zero seed gives each instance its own stream of a
+// common sequence (in patch initialisation order).
+static void rng_init(struct rng_state *r, uint32_t seed) {
+	static uint32_t instances = 0;
+	uint32_t x = (seed == 0) ? 0x5eed1234 : seed;
+	r->s0 = rng_splitmix(&x);
+	r->s1 = rng_splitmix(&x);
+	r->s2 = rng_splitmix(&x);
+	r->s3 = rng_splitmix(&x);
+	if (seed == 0) {
+		for (uint32_t i = 0; i < instances; i++) {
+			rng_jump(r);
+		}
+		instances++;
+	}
+}
+
+// fill a block with random bits (the state stays in registers for the block)
+DSP_INLINE void rng_block_n(struct rng_state *r, uint32_t * buf, size_t n) {
+	uint32_t s0 = r->s0;
+	uint32_t s1 = r->s1;
+	uint32_t s2 = r->s2;
+	uint32_t s3 = r->s3;
+	for (size_t i = 0; i < n; i++) {
+		buf[i] = s0 + s3;
+		uint32_t t = s1 << 9;
+		s2 ^= s0;
+		s3 ^= s1;
+		s1 ^= s2;
+		s0 ^= s3;
+		s2 ^= t;
+		s3 = rng_rotl(s3, 11);
+	}
+	r->s0 = s0;
+	r->s1 = s1;
+	r->s2 = s2;
+	r->s3 = s3;
+}
+
+static inline void rng_block(struct rng_state *r, uint32_t * buf) {
+	rng_block_n(r, buf, BUFSIZE);
+}
+
+// Convert random bits to a float [-1, 1).
+// The top 23 bits become the mantissa of a float in [2, 4), so there is no
+// int to float conversion. The sign bit is flipped so the result matches the
+// bits as a q1.31 (as used by the fixed point kernels).
+static inline float rng_float(uint32_t bits) {
+	union {
+		uint32_t i;
+		float f;
+	} x;
+	x.i = ((bits ^ 0x80000000) >> 9) | 0x40000000;
+	return x.f - 3.f;
 }
 
 //-----------------------------------------------------------------------------
 
 struct noise_state {
-	float b0, b1, b2, b3, b4, b5, b6;
+	struct rng_state rng;
+	float b0, b1, b2, b3, b4, b5, b6;	// float filter state
+	int32_t q0, q1, q2, q3, q4, q5, q6;	// fixed point filter state (q5.27, output scaled)
 };
 
-static void noise_init(struct noise_state *s) {
+static void noise_init(struct noise_state *s, uint32_t seed) {
 	memset(s, 0, sizeof(struct noise_state));
+	rng_init(&s->rng, seed);
 }
 
 //-----------------------------------------------------------------------------
 
 // white noise (spectral density = k)
-static void white_noise(int32_t * out) {
-	for (size_t i = 0; i < BUFSIZE; i++) {
-		out[i] = rand_s32() >> 4;
+DSP_INLINE void white_noise_n(struct noise_state *s, int32_t * out, size_t n) {
+	while (n > 0) {
+		size_t m = noise_block_n(n);
+		uint32_t r[NOISE_BLOCK_MAX];
+		rng_block_n(&s->rng, r, m);
+		for (size_t i = 0; i < m; i++) {
+			out[i] = (int32_t) r[i] >> 4;
+		}
+		out += m;
+		n -= m;
 	}
 }
 
+static void white_noise(struct noise_state *s, int32_t * out) {
+	white_noise_n(s, out, BUFSIZE);
+}
+
 // brown noise (spectral density = k/f*f
-static void brown_noise(struct noise_state *s, int32_t * out) {
+DSP_INLINE void brown_noise_n(struct noise_state *s, int32_t * out, size_t n) {
 	float b0 = s->b0;
-	for (size_t i = 0; i < BUFSIZE; i++) {
-		float white = rand_float();
-		b0 = (b0 + (0.02f * white)) * (1.f / 1.02f);
-		out[i] = float_to_q27(b0 * (1.f / 0.38f));
+	while (n > 0) {
+		size_t m = noise_block_n(n);
+		uint32_t r[NOISE_BLOCK_MAX];
+		rng_block_n(&s->rng, r, m);
+		for (size_t i = 0; i < m; i++) {
+			float white = rng_float(r[i]);
+			b0 = (b0 + (0.02f * white)) * (1.f / 1.02f);
+			out[i] = dsp_float_to_q27(b0 * (1.f / 0.38f));
+		}
+		out += m;
+		n -= m;
 	}
 	s->b0 = b0;
 }
 
+static void brown_noise(struct noise_state *s, int32_t * out) {
+	brown_noise_n(s, out, BUFSIZE);
+}
+
 // pink noise (spectral density = k/f): fast, inaccurate version
-static void pink_noise1(struct noise_state *s, int32_t * out) {
+DSP_INLINE void pink_noise1_n(struct noise_state *s, int32_t * out, size_t n) {
 	float b0 = s->b0;
 	float b1 = s->b1;
 	float b2 = s->b2;
-	for (size_t i = 0; i < BUFSIZE; i++) {
-		float white = rand_float();
-		b0 = 0.99765f * b0 + white * 0.0990460f;
-		b1 = 0.96300f * b1 + white * 0.2965164f;
-		b2 = 0.57000f * b2 + white * 1.0526913f;
-		float pink = b0 + b1 + b2 + white * 0.1848f;
-		out[i] = float_to_q27(pink * (1.f / 10.4f));
+	while (n > 0) {
+		size_t m = noise_block_n(n);
+		uint32_t r[NOISE_BLOCK_MAX];
+		rng_block_n(&s->rng, r, m);
+		for (size_t i = 0; i < m; i++) {
+			float white = rng_float(r[i]);
+			b0 = 0.99765f * b0 + white * 0.0990460f;
+			b1 = 0.96300f * b1 + white * 0.2965164f;
+			b2 = 0.57000f * b2 + white * 1.0526913f;
+			float pink = b0 + b1 + b2 + white * 0.1848f;
+			out[i] = dsp_float_to_q27(pink * (1.f / 10.4f));
+		}
+		out += m;
+		n -= m;
 	}
 	s->b0 = b0;
 	s->b1 = b1;
 	s->b2 = b2;
 }
 
+static void pink_noise1(struct noise_state *s, int32_t * out) {
+	pink_noise1_n(s, out, BUFSIZE);
+}
+
 // pink noise (spectral density = k/f): slow, accurate version
+DSP_INLINE void pink_noise2_n(struct noise_state *s, int32_t * out, size_t n) {
+	float b0 = s->b0;
+	float b1 = s->b1;
+	float b2 = s->b2;
+	float b3 = s->b3;
+	float b4 = s->b4;
+	float b5 = s->b5;
+	float b6 = s->b6;
+	while (n > 0) {
+		size_t m = noise_block_n(n);
+		uint32_t r[NOISE_BLOCK_MAX];
+		rng_block_n(&s->rng, r, m);
+		for (size_t i = 0; i < m; i++) {
+			float white = rng_float(r[i]);
+			b0 = 0.99886f * b0 + white * 0.0555179f;
+			b1 = 0.99332f * b1 + white * 0.0750759f;
+			b2 = 0.96900f * b2 + white * 0.1538520f;
+			b3 = 0.86650f * b3 + white * 0.3104856f;
+			b4 = 0.55000f * b4 + white * 0.5329522f;
+			b5 = -0.7616f * b5 - white * 0.0168980f;
+			float pink = b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362f;
+			b6 = white * 0.115926f;
+			out[i] = dsp_float_to_q27(pink * (1.f / 10.2f));
+		}
+		out += m;
+		n -= m;
+	}
+	s->b0 = b0;
+	s->b1 = b1;
+	s->b2 = b2;
+	s->b3 = b3;
+	s->b4 = b4;
+	s->b5 = b5;
+	s->b6 = b6;
+}
+
 static void pink_noise2(struct noise_state *s, int32_t * out) {
+	pink_noise2_n(s, out, BUFSIZE);
+}
+
+//-----------------------------------------------------------------------------
+// Voss-McCartney pink noise
+// See: http://www.firstpr.com.au/dsp/pink-noise/
+// Row k of the generator is updated every 2^(k+1) samples. The row to update
+// is the count of trailing zeroes of the sample counter, so each sample
+// updates a single row and the running sum (plus a white term).
+// The row value and the white term come from the high bits of separate random
+// values (the low bits of xoshiro128+ are its weakest).
+// Host (bench.py --eval, tsc cycles/block): ~200 versus ~140 (pink_noise1) and
+// ~320 (pink_noise2), with a -3.1 dB/octave slope over 40 Hz..16 kHz. Use the
+// profiler (prof.h) for target cycles/block.
+
+#define VOSS_ROWS 16		// the lowest rows update every 2^16 samples
+
+struct voss_state {
+	struct rng_state rng;
+	uint32_t count;		// sample counter
+	int32_t sum;		// running sum of the rows
+	int32_t row[VOSS_ROWS + 1];	// row values
+};
+
+static void voss_init(struct voss_state *s, uint32_t seed) {
+	memset(s, 0, sizeof(struct voss_state));
+	rng_init(&s->rng, seed);
+}
+
+// pink noise (spectral density = k/f): Voss-McCartney, O(1) per sample
+DSP_INLINE void pink_noise3_n(struct voss_state *s, int32_t * out, size_t n) {
+	uint32_t count = s->count;
+	int32_t sum = s->sum;
+	while (n > 0) {
+		size_t m = noise_block_n(n);
+		uint32_t r[NOISE_BLOCK_MAX];
+		uint32_t w[NOISE_BLOCK_MAX];
+		rng_block_n(&s->rng, r, m);
+		rng_block_n(&s->rng, w, m);
+		for (size_t i = 0; i < m; i++) {
+			count++;
+			// the count is never 0, row VOSS_ROWS takes the count == 0 (mod 2^16) case
+			int k = __builtin_ctz(count | (1U << VOSS_ROWS));
+			int32_t val = (int32_t) r[i] >> 8;
+			sum += val - s->row[k];
+			s->row[k] = val;
+			out[i] = sum + ((int32_t) w[i] >> 8);
+		}
+		out += m;
+		n -= m;
+	}
+	s->count = count;
+	s->sum = sum;
+}
+
+static void pink_noise3(struct voss_state *s, int32_t * out) {
+	pink_noise3_n(s, out, BUFSIZE);
+}
+
+//-----------------------------------------------------------------------------
+// Multi-tap noise: white, brown, pink1 and pink2 from a single white noise
+// source. Each random value is drawn once and feeds all of the filters in a
+// single loop.
+
+struct multi_noise_state {
+	struct rng_state rng;
+	float br;		// brown state
+	float a0, a1, a2;	// pink1 state
+	float b0, b1, b2, b3, b4, b5, b6;	// pink2 state
+};
+
+static void multi_noise_init(struct multi_noise_state *s, uint32_t seed) {
+	memset(s, 0, sizeof(struct multi_noise_state));
+	rng_init(&s->rng, seed);
+}
+
+static void multi_noise(struct multi_noise_state *s, int32_t * white_out, int32_t * brown_out, int32_t * pink1_out, int32_t * pink2_out) {
+	float br = s->br;
+	float a0 = s->a0;
+	float a1 = s->a1;
+	float a2 = s->a2;
 	float b0 = s->b0;
 	float b1 = s->b1;
 	float b2 = s->b2;
@@ -86,18 +358,36 @@ static void pink_noise2(struct noise_state *s, int32_t * out) {
 	float b4 = s->b4;
 	float b5 = s->b5;
 	float b6 = s->b6;
+	uint32_t r[BUFSIZE];
+	rng_block(&s->rng, r);
 	for (size_t i = 0; i < BUFSIZE; i++) {
-		float white = rand_float();
+		float white = rng_float(r[i]);
+		// white
+		white_out[i] = (int32_t) r[i] >> 4;
+		// brown
+		br = (br + (0.02f * white)) * (1.f / 1.02f);
+		brown_out[i] = dsp_float_to_q27(br * (1.f / 0.38f));
+		// pink1
+		a0 = 0.99765f * a0 + white * 0.0990460f;
+		a1 = 0.96300f * a1 + white * 0.2965164f;
+		a2 = 0.57000f * a2 + white * 1.0526913f;
+		float pink = a0 + a1 + a2 + white * 0.1848f;
+		pink1_out[i] = dsp_float_to_q27(pink * (1.f / 10.4f));
+		// pink2
 		b0 = 0.99886f * b0 + white * 0.0555179f;
 		b1 = 0.99332f * b1 + white * 0.0750759f;
 		b2 = 0.96900f * b2 + white * 0.1538520f;
 		b3 = 0.86650f * b3 + white * 0.3104856f;
 		b4 = 0.55000f * b4 + white * 0.5329522f;
 		b5 = -0.7616f * b5 - white * 0.0168980f;
-		float pink = b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362f;
+		pink = b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362f;
 		b6 = white * 0.115926f;
-		out[i] = float_to_q27(pink * (1.f / 10.2f));
+		pink2_out[i] = dsp_float_to_q27(pink * (1.f / 10.2f));
 	}
+	s->br = br;
+	s->a0 = a0;
+	s->a1 = a1;
+	s->a2 = a2;
 	s->b0 = b0;
 	s->b1 = b1;
 	s->b2 = b2;
@@ -107,6 +397,444 @@ static void pink_noise2(struct noise_state *s, int32_t * out) {
 	s->b6 = b6;
 }
 
+//-----------------------------------------------------------------------------
+// Noise bank: N decorrelated noise sources of the same color.
+// The filter state is kept as struct-of-arrays. Each lane's state is loaded
+// into locals for the block and stored once, so the sample loop runs out of
+// registers. The kernels are inlined and the lane count is an attribute (a
+// constant), so the lane loop is unrolled for the instance.
+// Host bench (8 lanes, pink2): ~860..910 ns/block for the bank versus
+// ~845..960 for 8 pink_noise2 instances, ie: parity. The bank saves patch
+// wiring and per-object overhead, not filter work. Running all lanes inside
+// the sample loop (to share the coefficient loads) measured up to ~50% slower
+// than separate instances: 7 states x 8 lanes don't fit in the registers.
+
+#define NOISE_LANES 8		// maximum number of lanes
+
+struct noise_bank_state {
+	struct rng_state rng[NOISE_LANES];
+	float b0[NOISE_LANES];
+	float b1[NOISE_LANES];
+	float b2[NOISE_LANES];
+	float b3[NOISE_LANES];
+	float b4[NOISE_LANES];
+	float b5[NOISE_LANES];
+	float b6[NOISE_LANES];
+};
+
+static void noise_bank_init(struct noise_bank_state *s, uint32_t seed) {
+	memset(s, 0, sizeof(struct noise_bank_state));
+	for (size_t l = 0; l < NOISE_LANES; l++) {
+		rng_init(&s->rng[l], seed);
+		// seeded lanes start on their own stream
+		for (size_t j = 0; (seed != 0) && (j < l); j++) {
+			rng_jump(&s->rng[l]);
+		}
+	}
+}
+
+// zero the outputs of the unused lanes
+static void noise_bank_zero(int n, int32_t ** out) {
+	for (int l = n; l < NOISE_LANES; l++) {
+		memset(out[l], 0, BUFSIZE * sizeof(int32_t));
+	}
+}
+
+// white noise bank
+DSP_INLINE void white_noise_bank(struct noise_bank_state *s, int n, int32_t ** out) {
+	for (int l = 0; l < n; l++) {
+		uint32_t r[BUFSIZE];
+		rng_block(&s->rng[l], r);
+		for (size_t i = 0; i < BUFSIZE; i++) {
+			out[l][i] = (int32_t) r[i] >> 4;
+		}
+	}
+	noise_bank_zero(n, out);
+}
+
+// brown noise bank
+DSP_INLINE void brown_noise_bank(struct noise_bank_state *s, int n, int32_t ** out) {
+	for (int l = 0; l < n; l++) {
+		float b0 = s->b0[l];
+		uint32_t r[BUFSIZE];
+		rng_block(&s->rng[l], r);
+		for (size_t i = 0; i < BUFSIZE; i++) {
+			float white = rng_float(r[i]);
+			b0 = (b0 + (0.02f * white)) * (1.f / 1.02f);
+			out[l][i] = dsp_float_to_q27(b0 * (1.f / 0.38f));
+		}
+		s->b0[l] = b0;
+	}
+	noise_bank_zero(n, out);
+}
+
+// pink noise bank: fast, inaccurate version
+DSP_INLINE void pink_noise1_bank(struct noise_bank_state *s, int n, int32_t ** out) {
+	for (int l = 0; l < n; l++) {
+		float b0 = s->b0[l];
+		float b1 = s->b1[l];
+		float b2 = s->b2[l];
+		uint32_t r[BUFSIZE];
+		rng_block(&s->rng[l], r);
+		for (size_t i = 0; i < BUFSIZE; i++) {
+			float white = rng_float(r[i]);
+			b0 = 0.99765f * b0 + white * 0.0990460f;
+			b1 = 0.96300f * b1 + white * 0.2965164f;
+			b2 = 0.57000f * b2 + white * 1.0526913f;
+			float pink = b0 + b1 + b2 + white * 0.1848f;
+			out[l][i] = dsp_float_to_q27(pink * (1.f / 10.4f));
+		}
+		s->b0[l] = b0;
+		s->b1[l] = b1;
+		s->b2[l] = b2;
+	}
+	noise_bank_zero(n, out);
+}
+
+// pink noise bank: slow, accurate version
+DSP_INLINE void pink_noise2_bank(struct noise_bank_state *s, int n, int32_t ** out) {
+	for (int l = 0; l < n; l++) {
+		float b0 = s->b0[l];
+		float b1 = s->b1[l];
+		float b2 = s->b2[l];
+		float b3 = s->b3[l];
+		float b4 = s->b4[l];
+		float b5 = s->b5[l];
+		float b6 = s->b6[l];
+		uint32_t r[BUFSIZE];
+		rng_block(&s->rng[l], r);
+		for (size_t i = 0; i < BUFSIZE; i++) {
+			float white = rng_float(r[i]);
+			b0 = 0.99886f * b0 + white * 0.0555179f;
+			b1 = 0.99332f * b1 + white * 0.0750759f;
+			b2 = 0.96900f * b2 + white * 0.1538520f;
+			b3 = 0.86650f * b3 + white * 0.3104856f;
+			b4 = 0.55000f * b4 + white * 0.5329522f;
+			b5 = -0.7616f * b5 - white * 0.0168980f;
+			float pink = b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362f;
+			b6 = white * 0.115926f;
+			out[l][i] = dsp_float_to_q27(pink * (1.f / 10.2f));
+		}
+		s->b0[l] = b0;
+		s->b1[l] = b1;
+		s->b2[l] = b2;
+		s->b3[l] = b3;
+		s->b4[l] = b4;
+		s->b5[l] = b5;
+		s->b6[l] = b6;
+	}
+	noise_bank_zero(n, out);
+}
+
+//-----------------------------------------------------------------------------
+// Variable slope (1/f^alpha) noise, alpha = 0 (white) .. 1 (pink) .. 2 (brown)
+// A cascade of first order sections with log spaced poles (10 Hz * 4^k). The
+// zeros sit above the poles by a factor of 4^(alpha/2), which gives an average
+// slope of -3*alpha dB/octave. The pole/zero frequencies are mapped to z with
+// exp(-2*pi*f/fs). The zeros and the output gain are looked up (and linearly
+// interpolated) from a table indexed by alpha. The poles don't depend on alpha.
+// When alpha changes the coefficients are ramped across the block.
+
+#define TILT_SECTIONS 6		// number of first order sections
+#define TILT_STEPS 17		// number of alpha table entries (steps of 1/8)
+
+// section poles
+static const float tilt_pole[TILT_SECTIONS] = {
+	0.99869186f, 0.99477770f, 0.97927385f, 0.91963741f, 0.71526426f, 0.26173758f,
+};
+
+// section zeros for alpha = 0, 1/8, 2/8 .. 2
+static const float tilt_zero[TILT_STEPS][TILT_SECTIONS] = {
+	{0.99869186f, 0.99477770f, 0.97927385f, 0.91963741f, 0.71526426f, 0.26173758f},
+	{0.99857355f, 0.99430639f, 0.97741931f, 0.91269076f, 0.69389637f, 0.23183472f},
+	{0.99844454f, 0.99379267f, 0.97540092f, 0.90517518f, 0.67132149f, 0.20310575f},
+	{0.99830388f, 0.99323277f, 0.97320460f, 0.89704991f, 0.64753974f, 0.17581896f},
+	{0.99815051f, 0.99262254f, 0.97081513f, 0.88827235f, 0.62256483f, 0.15022366f},
+	{0.99798329f, 0.99195752f, 0.96821609f, 0.87879823f, 0.59642618f, 0.12653969f},
+	{0.99780096f, 0.99123281f, 0.96538974f, 0.86858177f, 0.56917110f, 0.10494732f},
+	{0.99760217f, 0.99044312f, 0.96231699f, 0.85757598f, 0.54086693f, 0.08557791f},
+	{0.99738543f, 0.98958266f, 0.95897727f, 0.84573297f, 0.51160296f, 0.06850656f},
+	{0.99714913f, 0.98864519f, 0.95534850f, 0.83300443f, 0.48149218f, 0.05374734f},
+	{0.99689150f, 0.98762387f, 0.95140695f, 0.81934211f, 0.45067255f, 0.04125194f},
+	{0.99661064f, 0.98651133f, 0.94712719f, 0.80469854f, 0.41930772f, 0.03091231f},
+	{0.99630444f, 0.98529951f, 0.94248202f, 0.78902777f, 0.38758697f, 0.02256715f},
+	{0.99597064f, 0.98397972f, 0.93744239f, 0.77228633f, 0.35572418f, 0.01601229f},
+	{0.99560676f, 0.98254249f, 0.93197734f, 0.75443429f, 0.32395574f, 0.01101394f},
+	{0.99521009f, 0.98097757f, 0.92605398f, 0.73543655f, 0.29253703f, 0.00732358f},
+	{0.99477770f, 0.97927385f, 0.91963741f, 0.71526426f, 0.26173758f, 0.00469315f},
+};
+
+// output gain (constant rms) for alpha = 0, 1/8, 2/8 .. 2
+static const float tilt_gain[TILT_STEPS] = {
+	0.294449f, 0.293454f, 0.290028f, 0.283372f, 0.272500f, 0.256345f,
+	0.234103f, 0.205872f, 0.173291f, 0.139443f, 0.107741f, 0.080592f,
+	0.058892f, 0.042370f, 0.030192f, 0.021398f, 0.015127f,
+};
+
+struct tilt_state {
+	struct rng_state rng;
+	int32_t alpha;		// current alpha (inlet value)
+	float zero[TILT_SECTIONS];	// current zeros
+	float gain;		// current gain
+	float x1;		// white noise delay
+	float y1[TILT_SECTIONS];	// section output delays
+};
+
+// interpolate the zeros and gain from the table for an inlet value
+static void tilt_lookup(int32_t alpha, float *zero, float *gain) {
+	// 0..64 (q27) maps to alpha 0..2, 1/8 alpha per table step
+	if (alpha < 0) {
+		alpha = 0;
+	}
+	if (alpha >= (1 << 27)) {
+		alpha = (1 << 27) - 1;
+	}
+	int idx = alpha >> 23;
+	float frac = (float)(alpha & ((1 << 23) - 1)) * (1.f / (float)(1 << 23));
+	for (size_t k = 0; k < TILT_SECTIONS; k++) {
+		zero[k] = tilt_zero[idx][k] + frac * (tilt_zero[idx + 1][k] - tilt_zero[idx][k]);
+	}
+	*gain = tilt_gain[idx] + frac * (tilt_gain[idx + 1] - tilt_gain[idx]);
+}
+
+static void tilt_init(struct tilt_state *s, uint32_t seed) {
+	memset(s, 0, sizeof(struct tilt_state));
+	rng_init(&s->rng, seed);
+	tilt_lookup(0, s->zero, &s->gain);
+}
+
+// variable slope noise (spectral density = k/f^alpha)
+static void tilt_noise(struct tilt_state *s, int32_t alpha, int32_t * out) {
+	float zero[TILT_SECTIONS];
+	float dzero[TILT_SECTIONS];
+	float gain = s->gain;
+	float dgain = 0.f;
+	for (size_t k = 0; k < TILT_SECTIONS; k++) {
+		zero[k] = s->zero[k];
+		dzero[k] = 0.f;
+	}
+	// ramp the coefficients to the new alpha
+	if (alpha != s->alpha) {
+		float target[TILT_SECTIONS];
+		float tgain;
+		tilt_lookup(alpha, target, &tgain);
+		for (size_t k = 0; k < TILT_SECTIONS; k++) {
+			dzero[k] = (target[k] - zero[k]) * (1.f / (float)BUFSIZE);
+			s->zero[k] = target[k];
+		}
+		dgain = (tgain - gain) * (1.f / (float)BUFSIZE);
+		s->gain = tgain;
+		s->alpha = alpha;
+	}
+	float x1 = s->x1;
+	float y1[TILT_SECTIONS];
+	for (size_t k = 0; k < TILT_SECTIONS; k++) {
+		y1[k] = s->y1[k];
+	}
+	uint32_t r[BUFSIZE];
+	rng_block(&s->rng, r);
+	for (size_t i = 0; i < BUFSIZE; i++) {
+		float x = rng_float(r[i]);
+		float xp = x1;
+		x1 = x;
+		for (size_t k = 0; k < TILT_SECTIONS; k++) {
+			zero[k] += dzero[k];
+			float y = x - zero[k] * xp + tilt_pole[k] * y1[k];
+			xp = y1[k];
+			y1[k] = y;
+			x = y;
+		}
+		gain += dgain;
+		out[i] = dsp_float_to_q27(x * gain);
+	}
+	s->x1 = x1;
+	for (size_t k = 0; k < TILT_SECTIONS; k++) {
+		s->y1[k] = y1[k];
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Velvet noise: one +/-1 impulse at a random position in each grid period.
+// See: http://www.dafx14.fau.de/papers/dafx14_hannes_j_rvel_inen_generation_of_the_.pdf
+// The output block is zero filled, then the impulses are stored. The impulses
+// for the block are also available in sparse form (sample position and sign)
+// for use by sparse convolution code.
+// The grid period is not a whole number of samples, so the positions for
+// adjacent grid periods can round to the same sample. Each impulse is placed
+// at least one sample after the previous one, so impulses never overlap and
+// the sparse positions are strictly increasing.
+
+#define VELVET_DENSITY_MIN 100	// minimum density (impulses/sec)
+#define VELVET_DENSITY_MAX (SAMPLERATE / 2)	// maximum density (impulses/sec)
+#define VELVET_AMPLITUDE ((1 << 27) - 1)	// impulse amplitude (frac32 maximum)
+
+// impulses in the current block
+struct velvet_sparse {
+	int n;			// number of impulses
+	uint8_t pos[BUFSIZE];	// sample position within the block
+	int8_t sign[BUFSIZE];	// impulse sign (+1/-1)
+};
+
+struct velvet_state {
+	struct rng_state rng;
+	int32_t end;		// end of the current grid period (16.16 samples, relative to the block start)
+	uint32_t next;		// position of the next impulse (samples, relative to the block start)
+	uint32_t bits;		// random bits for the next impulse
+	struct velvet_sparse sparse;	// impulses in the current block
+};
+
+// return the impulse position for a grid period
+static inline uint32_t velvet_pos(int32_t start, uint32_t grid, uint32_t bits) {
+	// the top bit of the random value is the sign, the rest is the position
+	return (uint32_t) (start + (int32_t) (((uint64_t) (bits << 1) * grid) >> 32)) >> 16;
+}
+
+static void velvet_init(struct velvet_state *s, uint32_t seed) {
+	memset(s, 0, sizeof(struct velvet_state));
+	rng_init(&s->rng, seed);
+	s->end = ((uint64_t) SAMPLERATE << 16) / VELVET_DENSITY_MIN;
+	s->bits = rng_next(&s->rng);
+	s->next = velvet_pos(0, s->end, s->bits);
+}
+
+// velvet noise, density in impulses/sec
+static void velvet_noise(struct velvet_state *s, int32_t density, int32_t * out) {
+	// a density change takes effect at the next grid period
+	if (density < VELVET_DENSITY_MIN) {
+		density = VELVET_DENSITY_MIN;
+	}
+	if (density > VELVET_DENSITY_MAX) {
+		density = VELVET_DENSITY_MAX;
+	}
+	// grid period (16.16 samples)
+	uint32_t grid = ((uint64_t) SAMPLERATE << 16) / density;
+	struct velvet_sparse *sp = &s->sparse;
+	memset(out, 0, BUFSIZE * sizeof(int32_t));
+	sp->n = 0;
+	while (s->next < BUFSIZE) {
+		int32_t sign = (s->bits & 0x80000000) ? -1 : 1;
+		out[s->next] = sign * VELVET_AMPLITUDE;
+		sp->pos[sp->n] = s->next;
+		sp->sign[sp->n] = sign;
+		sp->n++;
+		// position of the impulse in the next grid period (after this one)
+		s->bits = rng_next(&s->rng);
+		uint32_t next = velvet_pos(s->end, grid, s->bits);
+		s->next = (next > s->next) ? next : s->next + 1;
+		s->end += grid;
+	}
+	s->end -= BUFSIZE << 16;
+	s->next -= BUFSIZE;
+}
+
+//-----------------------------------------------------------------------------
+// Fixed point versions of the colored noise kernels.
+// The white noise input is q1.31. The filter states are kept in q5.27 with
+// the output scaling folded into the input coefficients, so the output is the
+// sum of the states and there are no float conversions.
+// These are for parity with the float kernels (same spectrum, no FPU use),
+// not speed: on the host bench they are within run to run noise of the float
+// versions (pink2 ~105..155 versus ~110..160 ns/block) and sometimes slower.
+// There is no target (Cortex-M4) measurement yet.
+
+// float constant to q1.31
+#define NOISE_Q31(x) ((int32_t)((x) * 2147483648.0))
+
+// input coefficient: q1.31 white -> q5.27 state, with the output scaling
+#define NOISE_IN(x, scale) NOISE_Q31((x) / ((scale) * 16.0))
+
+// brown noise (spectral density = k/f*f): fixed point
+DSP_INLINE void brown_noise_q31_n(struct noise_state *s, int32_t * out, size_t n) {
+	int32_t q0 = s->q0;
+	while (n > 0) {
+		size_t m = noise_block_n(n);
+		uint32_t r[NOISE_BLOCK_MAX];
+		rng_block_n(&s->rng, r, m);
+		for (size_t i = 0; i < m; i++) {
+			int32_t white = (int32_t) r[i];
+			q0 = dsp_mac_q31(NOISE_Q31(1.0 / 1.02), q0, NOISE_IN(0.02 / 1.02, 0.38), white);
+			out[i] = q0;
+		}
+		out += m;
+		n -= m;
+	}
+	s->q0 = q0;
+}
+
+static void brown_noise_q31(struct noise_state *s, int32_t * out) {
+	brown_noise_q31_n(s, out, BUFSIZE);
+}
+
+// pink noise (spectral density = k/f): fast, inaccurate version, fixed point
+DSP_INLINE void pink_noise1_q31_n(struct noise_state *s, int32_t * out, size_t n) {
+	int32_t q0 = s->q0;
+	int32_t q1 = s->q1;
+	int32_t q2 = s->q2;
+	while (n > 0) {
+		size_t m = noise_block_n(n);
+		uint32_t r[NOISE_BLOCK_MAX];
+		rng_block_n(&s->rng, r, m);
+		for (size_t i = 0; i < m; i++) {
+			int32_t white = (int32_t) r[i];
+			q0 = dsp_mac_q31(NOISE_Q31(0.99765), q0, NOISE_IN(0.0990460, 10.4), white);
+			q1 = dsp_mac_q31(NOISE_Q31(0.96300), q1, NOISE_IN(0.2965164, 10.4), white);
+			q2 = dsp_mac_q31(NOISE_Q31(0.57000), q2, NOISE_IN(1.0526913, 10.4), white);
+			int32_t q3 = dsp_mul_q31(NOISE_IN(0.1848, 10.4), white);
+			out[i] = q0 + q1 + q2 + q3;
+		}
+		out += m;
+		n -= m;
+	}
+	s->q0 = q0;
+	s->q1 = q1;
+	s->q2 = q2;
+}
+
+static void pink_noise1_q31(struct noise_state *s, int32_t * out) {
+	pink_noise1_q31_n(s, out, BUFSIZE);
+}
+
+// pink noise (spectral density = k/f): slow, accurate version, fixed point
+DSP_INLINE void pink_noise2_q31_n(struct noise_state *s, int32_t * out, size_t n) {
+	int32_t q0 = s->q0;
+	int32_t q1 = s->q1;
+	int32_t q2 = s->q2;
+	int32_t q3 = s->q3;
+	int32_t q4 = s->q4;
+	int32_t q5 = s->q5;
+	int32_t q6 = s->q6;
+	while (n > 0) {
+		size_t m = noise_block_n(n);
+		uint32_t r[NOISE_BLOCK_MAX];
+		rng_block_n(&s->rng, r, m);
+		for (size_t i = 0; i < m; i++) {
+			int32_t white = (int32_t) r[i];
+			q0 = dsp_mac_q31(NOISE_Q31(0.99886), q0, NOISE_IN(0.0555179, 10.2), white);
+			q1 = dsp_mac_q31(NOISE_Q31(0.99332), q1, NOISE_IN(0.0750759, 10.2), white);
+			q2 = dsp_mac_q31(NOISE_Q31(0.96900), q2, NOISE_IN(0.1538520, 10.2), white);
+			q3 = dsp_mac_q31(NOISE_Q31(0.86650), q3, NOISE_IN(0.3104856, 10.2), white);
+			q4 = dsp_mac_q31(NOISE_Q31(0.55000), q4, NOISE_IN(0.5329522, 10.2), white);
+			q5 = dsp_mac_q31(NOISE_Q31(-0.7616), q5, NOISE_IN(-0.0168980, 10.2), white);
+			int32_t q7 = dsp_mul_q31(NOISE_IN(0.5362, 10.2), white);
+			out[i] = q0 + q1 + q2 + q3 + q4 + q5 + q6 + q7;
+			q6 = dsp_mul_q31(NOISE_IN(0.115926, 10.2), white);
+		}
+		out += m;
+		n -= m;
+	}
+	s->q0 = q0;
+	s->q1 = q1;
+	s->q2 = q2;
+	s->q3 = q3;
+	s->q4 = q4;
+	s->q5 = q5;
+	s->q6 = q6;
+}
+
+static void pink_noise2_q31(struct noise_state *s, int32_t * out) {
+	pink_noise2_q31_n(s, out, BUFSIZE);
+}
+
 //-----------------------------------------------------------------------------
 
 #endif				// DEADSY_NOISE_H
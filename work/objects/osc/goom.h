@@ -16,6 +16,18 @@ slope = split s0f0 and s1f1 beween slope and flat.
 
 The idea for goom waves comes from: https://www.quinapalus.com/goom.html
 
+goom_krate computes the wave directly (naive, aliases at high pitch).
+goom_blep_krate adds a band-limiting correction to the samples either side
+of each segment transition (see goom_corners).
+goom_table_krate plays the wave from a band-limited mip-mapped wave table.
+The tables are rendered on a shape change and kept in a small cache that is
+shared by the table mode instances of a patch, so table mode suits static or
+slowly changing shapes. A rapidly modulated duty/slope re-renders on every
+change. Instances with the same shape share a cache entry. The cache holds
+GOOM_CACHE_SIZE distinct shapes, an instance that can't get an entry runs
+the blep kernel until one is free. The cache is only referenced by the
+table mode code, so it costs nothing in patches that don't use table mode.
+
 */
 //-----------------------------------------------------------------------------
 
@@ -24,12 +36,20 @@ The idea for goom waves comes from: https://www.quinapalus.com/goom.html
 
 //-----------------------------------------------------------------------------
 
+#include "../dsp/dsp.h"
+
+//-----------------------------------------------------------------------------
+
 // Limit how close the duty cycle can get to 0/100%.
 #define TP_MIN 0.1f
 
 // Limit how fast the slope can rise.
 #define SLOPE_MIN 0.1f
 
+// Kernels with an _n suffix take the block size as an argument. They are
+// always inlined (DSP_INLINE), so the BUFSIZE wrappers (and other fixed size
+// callers) get a copy specialized for a constant size.
+
 #define FULL_CYCLE ((float)(1ULL << 32))
 #define CYCLE_1_2 ((uint32_t)(1U << 31))
 #define CYCLE_1_4 ((uint32_t)(1U << 30))
@@ -43,70 +63,690 @@ static float midi_map(uint8_t val, float a, float b) {
 }
 
 //-----------------------------------------------------------------------------
+// mip-mapped wave tables
 
-struct goom_state {
+#define GOOM_TABLE_BITS 8	// log2 of the level 0 table size
+#define GOOM_TABLE_SIZE (1 << GOOM_TABLE_BITS)
+#define GOOM_LEVELS 6		// 256, 128, 64, 32, 16 and 8 samples
+#define GOOM_GUARD 3		// guard samples per level (cubic interpolation)
+#define GOOM_TABLE_DATA ((2 * GOOM_TABLE_SIZE) - (GOOM_TABLE_SIZE >> (GOOM_LEVELS - 1)) + (GOOM_GUARD * GOOM_LEVELS))
+#ifndef GOOM_CACHE_SIZE
+#define GOOM_CACHE_SIZE 4	// shared cache entries (distinct table mode shapes, ~2KB each)
+#endif
+
+struct goom_wave {
 	uint8_t duty;		// duty cycle 0..127
 	uint8_t slope;		// slope 0..127
-	float k0;		// scaling factor for slope 0
-	float k1;		// scaling factor for slope 1
+	uint8_t users;		// instances using this entry (0 = free)
+	float *level[GOOM_LEVELS];	// level l: x[-1], x[0..(GOOM_TABLE_SIZE >> l) - 1], x[n], x[n+1] (q27 scaled)
+	float data[GOOM_TABLE_DATA];
+};
+
+struct goom_cache {
+	struct goom_wave wave[GOOM_CACHE_SIZE];
+};
+
+static struct goom_cache goom_cache;
+
+// halfband lowpass (23 taps, blackman window), odd taps on one side.
+// The even taps are 0 and the center tap is 0.5.
+#define GOOM_HB_TAPS 6
+static const float goom_hb[GOOM_HB_TAPS] = {
+	0.309390819f, -0.082054191f, 0.030557533f, -0.010060781f, 0.002349427f, -0.000182808f,
+};
+
+//-----------------------------------------------------------------------------
+// shape tables
+
+// k0 = 1/(tp * fslope) and k1 = 1/((FULL_CYCLE - tp) * fslope) are separable
+// in duty and slope, so a shape change is a table lookup and two multiplies.
+// The tables are shared by all goom instances and filled on the first init.
+
+#define GOOM_STEPS 128
+
+// The pitch table is one octave of frequency ratios, so it doesn't depend on
+// the sample rate. SAMPLERATE only sets the phase step for 440 Hz.
+#define GOOM_PITCH_BITS 8
+#define GOOM_PITCH_SIZE (1 << GOOM_PITCH_BITS)
+#define GOOM_PITCH_BASE ((uint32_t)(440.0 * 4294967296.0 / (double)SAMPLERATE))
+
+struct goom_tables {
+	uint32_t tp[GOOM_STEPS];	// s0f0 to s1f1 transition point (duty)
+	float rtp0[GOOM_STEPS];	// 1/tp (duty)
+	float rtp1[GOOM_STEPS];	// 1/(FULL_CYCLE - tp) (duty)
+	float fslope[GOOM_STEPS];	// fslope (slope)
+	float rslope[GOOM_STEPS];	// 1/fslope (slope)
+	int32_t f0;		// f0 (bottom) value
+	int32_t f1;		// f1 (top) value
+	uint32_t pitch[GOOM_PITCH_SIZE + 1];	// 2^(i/GOOM_PITCH_SIZE) as q2.30
+	bool ready;
+};
+
+static struct goom_tables goom_tables;
+
+static void goom_tables_init(void) {
+	struct goom_tables *t = &goom_tables;
+	if (t->ready) {
+		return;
+	}
+	for (int i = 0; i < GOOM_STEPS; i++) {
+		// map midi control values to the range limits
+		float fduty = midi_map(i, TP_MIN, 1.f - TP_MIN);
+		float fslope = midi_map(i, SLOPE_MIN, 1.f);
+		t->tp[i] = (uint32_t) (FULL_CYCLE * fduty);
+		t->rtp0[i] = 1.f / (float)t->tp[i];
+		t->rtp1[i] = 1.f / (FULL_CYCLE - (float)t->tp[i]);
+		t->fslope[i] = fslope;
+		t->rslope[i] = 1.f / fslope;
+	}
+	t->f0 = sin_q31(CYCLE_3_4) >> 4;
+	t->f1 = sin_q31(CYCLE_1_4) >> 4;
+	for (int i = 0; i <= GOOM_PITCH_SIZE; i++) {
+		t->pitch[i] = (uint32_t) (exp2((double)i / (double)GOOM_PITCH_SIZE) * (double)(1 << 30));
+	}
+	t->ready = true;
+}
+
+// q11.21 pitch (0 = midi note 64) to a phase step
+static inline uint32_t goom_pitch_step(int32_t pitch) {
+	// octaves relative to 440 Hz (midi note 69) as q8.24: semitones * 8/12
+	int32_t semis = pitch - (5 << 21);
+	semis = (semis > (256 << 21)) ? (256 << 21) : semis;
+	semis = (semis < -(256 << 21)) ? -(256 << 21) : semis;
+	int32_t oct = (int32_t) (((int64_t) semis * 0xaaaaaaabLL) >> 32);
+	int e = oct >> 24;
+	if (e > 6) {
+		return UINT32_MAX;
+	}
+	if (e < -31) {
+		return 0;
+	}
+	// interpolate the ratio for the fraction of an octave
+	uint32_t frac = (uint32_t) oct & 0xffffff;
+	const uint32_t *r = &goom_tables.pitch[frac >> (24 - GOOM_PITCH_BITS)];
+	uint32_t f = frac & ((1 << (24 - GOOM_PITCH_BITS)) - 1);
+	uint32_t ratio = r[0] + (uint32_t) (((uint64_t) (r[1] - r[0]) * f) >> (24 - GOOM_PITCH_BITS));
+	uint64_t step = ((uint64_t) ratio * GOOM_PITCH_BASE) >> 30;
+	step = (e >= 0) ? (step << e) : (step >> -e);
+	return (step > UINT32_MAX) ? UINT32_MAX : (uint32_t) step;
+}
+
+//-----------------------------------------------------------------------------
+
+struct goom_shape {
+	uint8_t duty;		// duty cycle 0..127
+	uint8_t slope;		// slope 0..127
+	float k0;		// phase to sine argument scaling for slope 0
+	float k1;		// phase to sine argument scaling for slope 1
+	uint32_t sat0;		// s0 to f0 transition point
 	uint32_t tp;		// s0f0 to s1f1 transition point
+	uint32_t sat1;		// s1 to f1 transition point
+};
+
+struct goom_state {
+	struct goom_shape shape;	// wave shape
 	uint32_t x;		// phase position
 	uint32_t xstep;		// phase step per sample
+	struct goom_wave *wave;	// wave table (table mode)
+	float blep;		// corner correction for the next block (blep mode)
 };
 
 //-----------------------------------------------------------------------------
 
 static void goom_init(struct goom_state *s) {
 	memset(s, 0, sizeof(struct goom_state));
+	goom_tables_init();
 	// force an initial update
-	s->duty = 0xff;
+	s->shape.duty = 0xff;
+}
+
+//-----------------------------------------------------------------------------
+// segment runs
+
+// s0/s1: sine run with a linearly stepped argument
+static void goom_sine(int32_t * out, size_t n, uint32_t arg, uint32_t darg) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = sin_q31(arg) >> 4;
+		arg += darg;
+	}
+}
+
+// f0/f1: flat run
+static void goom_fill(int32_t * out, size_t n, int32_t val) {
+	for (size_t i = 0; i < n; i++) {
+		out[i] = val;
+	}
+}
+
+// return the number of samples (up to max) to cover dist: ceil(dist / xstep)
+static inline size_t goom_samples(uint32_t dist, uint32_t xstep, size_t max) {
+	if (xstep == 0) {
+		return max;
+	}
+	size_t n = ((dist - 1) / xstep) + 1;
+	return (n < max) ? n : max;
+}
+
+// return the sine argument for a phase offset within s0/s1
+static inline uint32_t goom_arg(uint32_t x, float k) {
+	float arg = (float)x * k;
+	return (arg < (float)CYCLE_1_2) ? (uint32_t) arg : CYCLE_1_2;
 }
 
 //-----------------------------------------------------------------------------
 
-static void goom_krate(struct goom_state *s,	// state
-		       int32_t pitch,	// inlet q11.21
-		       const int32_t * freq,	// inlet q5.27
-		       const int32_t * phase,	// inlet q5.27
-		       int32_t duty,	// inlet 0..127
-		       int32_t slope,	// inlet 0..127
-		       int32_t * out	// outlet q5.27
+// update the wave shape for new duty/slope values
+static void goom_set_shape(struct goom_shape *sh, int32_t duty, int32_t slope) {
+	const struct goom_tables *t = &goom_tables;
+	sh->duty = duty;
+	sh->slope = slope;
+	duty &= 0x7f;
+	slope &= 0x7f;
+	float rslope = t->rslope[slope] * (float)CYCLE_1_2;
+	// This is where we transition from s0f0 to s1f1.
+	sh->tp = t->tp[duty];
+	// scaling constant for s0, map the slope to the LUT.
+	sh->k0 = t->rtp0[duty] * rslope;
+	// scaling constant for s1, map the slope to the LUT.
+	sh->k1 = t->rtp1[duty] * rslope;
+	// This is where the slopes saturate to the flat pieces.
+	uint32_t w0 = (uint32_t) ((float)sh->tp * t->fslope[slope]);
+	uint32_t w1 = (uint32_t) ((FULL_CYCLE - (float)sh->tp) * t->fslope[slope]);
+	sh->sat0 = (w0 < sh->tp) ? w0 : sh->tp;
+	sh->sat1 = (w1 < ~sh->tp) ? sh->tp + w1 : 0xffffffff;
+}
+
+// return the wave value (q27) at phase x
+static int32_t goom_value(const struct goom_shape *sh, uint32_t x) {
+	uint32_t arg;
+	if (x < sh->tp) {
+		arg = goom_arg(x, sh->k0) + CYCLE_1_4;
+	} else {
+		arg = goom_arg(x - sh->tp, sh->k1) + CYCLE_3_4;
+	}
+	return sin_q31(arg) >> 4;
+}
+
+// generate a block with a fixed phase step, return the final phase.
+// The phase step is constant across the block, so split the block at the
+// segment boundaries and run each segment without per sample tests.
+DSP_INLINE uint32_t goom_segments_n(const struct goom_shape *sh, uint32_t x, uint32_t xstep, int32_t * out, size_t n) {
+	size_t i = 0;
+	while (i < n) {
+		size_t m;
+		if (x < sh->sat0) {
+			m = goom_samples(sh->sat0 - x, xstep, n - i);
+			goom_sine(&out[i], m, goom_arg(x, sh->k0) + CYCLE_1_4, goom_arg(xstep, sh->k0));
+		} else if (x < sh->tp) {
+			m = goom_samples(sh->tp - x, xstep, n - i);
+			goom_fill(&out[i], m, goom_tables.f0);
+		} else if (x < sh->sat1) {
+			m = goom_samples(sh->sat1 - x, xstep, n - i);
+			goom_sine(&out[i], m, goom_arg(x - sh->tp, sh->k1) + CYCLE_3_4, goom_arg(xstep, sh->k1));
+		} else {
+			// up to the wrap
+			m = goom_samples(-x, xstep, n - i);
+			goom_fill(&out[i], m, goom_tables.f1);
+		}
+		// step the phase
+		x += (uint32_t) m *xstep;
+		i += m;
+	}
+	return x;
+}
+
+// return true if all the samples in the buffer have the same value
+static inline bool goom_is_const(const int32_t * buf, size_t n) {
+	int32_t x = 0;
+	for (size_t i = 1; i < n; i++) {
+		x |= buf[i] ^ buf[0];
+	}
+	return x == 0;
+}
+
+// Linear FM (freq) adds to the phase step, PM (phase) offsets the phase.
+// If both are constant across the block (typically unconnected/zero) return
+// true with the fixed phase step and offset.
+static bool goom_fixed_step(uint32_t xstep, const int32_t * freq, const int32_t * phase, size_t n, uint32_t * step, uint32_t * pofs) {
+	if (!goom_is_const(freq, n) || !goom_is_const(phase, n)) {
+		return false;
+	}
+	// through zero fm needs the per sample loop
+	int64_t x = (int64_t) xstep + freq[0];
+	if ((x < 0) || (x > (int64_t) UINT32_MAX)) {
+		return false;
+	}
+	*step = (uint32_t) x;
+	*pofs = (uint32_t) phase[0] << 4;
+	return true;
+}
+
+DSP_INLINE void goom_krate_n(struct goom_state *s,	// state
+			     int32_t pitch,	// inlet q11.21
+			     const int32_t * freq,	// inlet q5.27
+			     const int32_t * phase,	// inlet q5.27
+			     int32_t duty,	// inlet 0..127
+			     int32_t slope,	// inlet 0..127
+			     int32_t * out,	// outlet q5.27
+			     size_t n	// block size
     ) {
 
 	// do we need to change the wave shape?
-	if ((duty != s->duty) || (slope != s->slope)) {
-		s->duty = duty;
-		s->slope = slope;
-		// map midi control values to the range limits
-		float fduty = midi_map(duty, TP_MIN, 1.f - TP_MIN);
-		float fslope = midi_map(slope, SLOPE_MIN, 1.f);
-		// This is where we transition from s0f0 to s1f1.
-		s->tp = (uint32_t) (FULL_CYCLE * fduty);
-		// scaling constant for s0, map the slope to the LUT.
-		s->k0 = 1.f / ((float)s->tp * fslope);
-		// scaling constant for s1, map the slope to the LUT.
-		s->k1 = 1.f / ((FULL_CYCLE - (float)s->tp) * fslope);
-	}
-
-	s->xstep = mtof48k_ext_q31(pitch);
-
-	for (size_t i = 0; i < BUFSIZE; i++) {
-		uint32_t ofs;
-		float x;
-		// what portion of the goom wave are we in?
-		if (s->x < s->tp) {
-			// we are in the s0/f0 portion
-			x = (float)s->x * s->k0;
-			ofs = CYCLE_1_4;
+	if ((duty != s->shape.duty) || (slope != s->shape.slope)) {
+		goom_set_shape(&s->shape, duty, slope);
+	}
+
+	s->xstep = goom_pitch_step(pitch);
+
+	// fast path: no modulation (or constant modulation)
+	uint32_t step;
+	uint32_t pofs;
+	if (goom_fixed_step(s->xstep, freq, phase, n, &step, &pofs)) {
+		s->x = goom_segments_n(&s->shape, s->x + pofs, step, out, n) - pofs;
+		return;
+	}
+	// per sample fm/pm
+	uint32_t x = s->x;
+	for (size_t i = 0; i < n; i++) {
+		out[i] = goom_value(&s->shape, x + ((uint32_t) phase[i] << 4));
+		x += s->xstep + freq[i];
+	}
+	s->x = x;
+
+}
+
+static void goom_krate(struct goom_state *s, int32_t pitch, const int32_t * freq, const int32_t * phase, int32_t duty, int32_t slope, int32_t * out) {
+	goom_krate_n(s, pitch, freq, phase, duty, slope, out, BUFSIZE);
+}
+
+//-----------------------------------------------------------------------------
+// blep mode
+
+// The goom wave is C1 at the segment transitions (the sines start and end
+// with zero slope), the discontinuity is in the second derivative. For a
+// curvature jump of 1 at t = 0 the correction is the difference between the
+// triangle (polyBLEP) filtered and the naive waveform, less the small offset
+// the filter leaves on the curved side:
+// c(t) = sign(t) * (u^2 - u^4) / 24, u = 1 - |t|, |t| < 1 (t in samples)
+static inline float goom_blep2(float u) {
+	float u2 = u * u;
+	return (u2 - (u2 * u2)) * (1.f / 24.f);
+}
+
+// A sine segment shorter than GOOM_BLEP_MIN samples (or any segment at less
+// than 4 samples per cycle) is treated as a step at its midpoint: its samples
+// are set to the levels either side of the step and the step is corrected.
+// The curvature correction scales with 1/length^2, so it is only used where
+// it is small. The correction for a step of 1 at t = 0 is:
+// c(t) = -sign(t) * u^2 / 2, u = 1 - |t|, |t| < 1 (t in samples)
+#define GOOM_BLEP_MIN 2.f
+
+static inline float goom_blep1(float u) {
+	return 0.5f * u * u;
+}
+
+// Add a curvature jump correction of d at each crossing of a phase in the
+// block. t (0 <= t < cycle) is the time (samples from out[0]) of the first
+// crossing. Return the correction for the first sample of the next block.
+static float goom_corner(int32_t * out, size_t n, float t, float cycle, float d) {
+	float next = 0.f;
+	for (; t < (float)n; t += cycle) {
+		size_t j = (size_t)t;
+		float f = t - (float)j;
+		out[j] = dsp_qsub(out[j], (int32_t) (d * goom_blep2(1.f - f)));
+		if (j + 1 < n) {
+			out[j + 1] = dsp_qadd(out[j + 1], (int32_t) (d * goom_blep2(f)));
 		} else {
-			// we are in the s1/f1 portion
-			x = (float)(s->x - s->tp) * s->k1;
-			ofs = CYCLE_3_4;
+			next += d * goom_blep2(f);
 		}
-		x = (x > 1.f) ? 1.f : x;
-		out[i] = sin_q31((uint32_t) (x * (float)CYCLE_1_2) + ofs) >> 4;
-		// step the phase
-		s->x += s->xstep;
+	}
+	return next;
+}
+
+// As above, for a step of h.
+static float goom_step(int32_t * out, size_t n, float t, float cycle, float h) {
+	float next = 0.f;
+	for (; t < (float)n; t += cycle) {
+		size_t j = (size_t)t;
+		float f = t - (float)j;
+		out[j] = dsp_qadd(out[j], (int32_t) (h * goom_blep1(1.f - f)));
+		if (j + 1 < n) {
+			out[j + 1] = dsp_qsub(out[j + 1], (int32_t) (h * goom_blep1(f)));
+		} else {
+			next -= h * goom_blep1(f);
+		}
+	}
+	return next;
+}
+
+// Set the samples of a segment (starting at t, len samples long) to v0 before
+// its midpoint and v1 after it. This includes a segment that started in the
+// previous block.
+static void goom_flatten(int32_t * out, size_t n, float t, float cycle, float len, int32_t v0, int32_t v1) {
+	for (t -= cycle; t < (float)n; t += cycle) {
+		float mid = t + (0.5f * len);
+		float end = t + len;
+		// first sample at or after t
+		int i = (t > 0.f) ? (int)t : 0;
+		i += ((float)i < t);
+		for (; (i < (int)n) && ((float)i < end); i++) {
+			out[i] = ((float)i < mid) ? v0 : v1;
+		}
+	}
+}
+
+// Add the corrections for a sine segment that starts at t (0 <= t < cycle)
+// and is len samples long. w is the sine frequency (radians per sample), h is
+// the change in value across the segment. A step segment has already been
+// flattened.
+static float goom_segment(int32_t * out, size_t n, float t, float len, float cycle, float w, float h, bool step) {
+	if (step) {
+		float mid = t + (0.5f * len);
+		return goom_step(out, n, (mid >= cycle) ? mid - cycle : mid, cycle, h);
+	}
+	// The curvature jumps by h/2 * w^2 at both ends of the segment. It is
+	// limited to the swing between the flat pieces.
+	const float dmax = (float)goom_tables.f1 - (float)goom_tables.f0;
+	float d = 0.5f * h * w * w;
+	d = (d > dmax) ? dmax : d;
+	d = (d < -dmax) ? -dmax : d;
+	float end = t + len;
+	return goom_corner(out, n, t, cycle, d) + goom_corner(out, n, (end >= cycle) ? end - cycle : end, cycle, d);
+}
+
+// Add the corner corrections to a block generated from phase x with a fixed
+// phase step. Return the correction for the first sample of the next block.
+static float goom_corners(const struct goom_shape *sh, uint32_t x, uint32_t xstep, int32_t * out, size_t n) {
+	if (xstep == 0) {
+		return 0.f;
+	}
+	float rstep = 1.f / (float)xstep;
+	float cycle = FULL_CYCLE * rstep;	// samples per cycle
+	// s0 falls from f1 to f0, s1 rises from f0 to f1
+	const float h = (float)goom_tables.f1 - (float)goom_tables.f0;
+	const float w = (float)xstep * (3.14159265f / (float)CYCLE_1_2);
+	float len0 = (float)sh->sat0 * rstep;
+	float len1 = (float)(sh->sat1 - sh->tp) * rstep;
+	// The segments are flattened before any correction is added, so the
+	// corrections from one segment aren't overwritten by the other.
+	float t0 = (float)(0 - x) * rstep;
+	float t1 = (float)(sh->tp - x) * rstep;
+	bool step0 = (len0 < GOOM_BLEP_MIN) || (cycle < 4.f);
+	bool step1 = (len1 < GOOM_BLEP_MIN) || (cycle < 4.f);
+	if (step0) {
+		goom_flatten(out, n, t0, cycle, len0, goom_tables.f1, goom_tables.f0);
+	}
+	if (step1) {
+		goom_flatten(out, n, t1, cycle, len1, goom_tables.f0, goom_tables.f1);
+	}
+	float next = goom_segment(out, n, t0, len0, cycle, w * sh->k0, -h, step0);
+	next += goom_segment(out, n, t1, len1, cycle, w * sh->k1, h, step1);
+	return next;
+}
+
+DSP_INLINE void goom_blep_krate_n(struct goom_state *s,	// state
+				  int32_t pitch,	// inlet q11.21
+				  const int32_t * freq,	// inlet q5.27
+				  const int32_t * phase,	// inlet q5.27
+				  int32_t duty,	// inlet 0..127
+				  int32_t slope,	// inlet 0..127
+				  int32_t * out,	// outlet q5.27
+				  size_t n	// block size
+    ) {
+
+	// do we need to change the wave shape?
+	if ((duty != s->shape.duty) || (slope != s->shape.slope)) {
+		goom_set_shape(&s->shape, duty, slope);
+	}
+
+	s->xstep = goom_pitch_step(pitch);
+
+	uint32_t step;
+	uint32_t pofs;
+	if (goom_fixed_step(s->xstep, freq, phase, n, &step, &pofs)) {
+		uint32_t x = s->x + pofs;
+		s->x = goom_segments_n(&s->shape, x, step, out, n) - pofs;
+		// the carry is added after the corrections (they can flatten out[0])
+		float next = goom_corners(&s->shape, x, step, out, n);
+		out[0] += (int32_t) s->blep;
+		s->blep = next;
+		return;
+	}
+	// per sample fm/pm (not corrected)
+	uint32_t x = s->x;
+	for (size_t i = 0; i < n; i++) {
+		out[i] = goom_value(&s->shape, x + ((uint32_t) phase[i] << 4));
+		x += s->xstep + freq[i];
+	}
+	out[0] += (int32_t) s->blep;
+	s->blep = 0.f;
+	s->x = x;
+
+}
+
+static void goom_blep_krate(struct goom_state *s, int32_t pitch, const int32_t * freq, const int32_t * phase, int32_t duty, int32_t slope, int32_t * out) {
+	goom_blep_krate_n(s, pitch, freq, phase, duty, slope, out, BUFSIZE);
+}
+
+//-----------------------------------------------------------------------------
+// table mode
+
+// decimate one cycle of 2n samples to n samples (periodic halfband filter)
+static void goom_decimate(float *dst, const float *src, int n) {
+	int mask = (2 * n) - 1;
+	for (int i = 0; i < n; i++) {
+		int j = 2 * i;
+		float acc = 0.5f * src[j];
+		for (int k = 0; k < GOOM_HB_TAPS; k++) {
+			int d = (2 * k) + 1;
+			acc += goom_hb[k] * (src[(j + d) & mask] + src[(j - d) & mask]);
+		}
+		dst[i] = acc;
+	}
+}
+
+// render the mip levels for the current shape
+static void goom_render(struct goom_wave *w, const struct goom_shape *sh) {
+	static float buf0[2 * GOOM_TABLE_SIZE];
+	static float buf1[GOOM_TABLE_SIZE];
+	// one cycle at twice the level 0 size
+	for (int i = 0; i < 2 * GOOM_TABLE_SIZE; i++) {
+		buf0[i] = (float)goom_value(sh, (uint32_t) i << (32 - GOOM_TABLE_BITS - 1)) * (1.f / (float)(1 << 27));
+	}
+	// each level is the halfband decimation of the previous one
+	float *src = buf0;
+	float *dst = buf1;
+	float *data = w->data;
+	int n = GOOM_TABLE_SIZE;
+	for (int l = 0; l < GOOM_LEVELS; l++) {
+		goom_decimate(dst, src, n);
+		// periodic guard samples for the interpolation
+		w->level[l] = &data[1];
+		data[0] = dst[n - 1] * (float)(1 << 27);
+		for (int i = 0; i < n; i++) {
+			data[i + 1] = dst[i] * (float)(1 << 27);
+		}
+		data[n + 1] = data[1];
+		data[n + 2] = data[2];
+		data += n + GOOM_GUARD;
+		src = dst;
+		dst = (dst == buf1) ? buf0 : buf1;
+		n >>= 1;
+	}
+}
+
+// Return a cache entry for the current shape. An entry with the same shape
+// is shared, otherwise a free entry is rendered. Returns NULL if the cache is
+// full. Entries are never taken from another instance, so instances don't
+// re-render each other's tables.
+static struct goom_wave *goom_wave_get(const struct goom_state *s) {
+	struct goom_cache *c = &goom_cache;
+	uint8_t duty = s->shape.duty & 0x7f;
+	uint8_t slope = s->shape.slope & 0x7f;
+	struct goom_wave *unused = NULL;
+	for (int i = 0; i < GOOM_CACHE_SIZE; i++) {
+		struct goom_wave *w = &c->wave[i];
+		if (w->users == 0) {
+			unused = (unused == NULL) ? w : unused;
+		} else if ((w->duty == duty) && (w->slope == slope)) {
+			w->users++;
+			return w;
+		}
+	}
+	if (unused != NULL) {
+		unused->duty = duty;
+		unused->slope = slope;
+		unused->users = 1;
+		goom_render(unused, &s->shape);
+	}
+	return unused;
+}
+
+// release a cache entry
+static void goom_wave_put(struct goom_wave *w) {
+	if (w != NULL) {
+		w->users--;
+	}
+}
+
+// return the mip level for a phase step
+static inline int goom_level(uint32_t xstep) {
+	// largest table with all harmonics below nyquist: size * xstep <= 2^32
+	if (xstep <= (1U << (32 - GOOM_TABLE_BITS))) {
+		return 0;
+	}
+	int l = (32 - __builtin_clz(xstep - 1)) - (32 - GOOM_TABLE_BITS);
+	return (l < GOOM_LEVELS) ? l : GOOM_LEVELS - 1;
+}
+
+// return the cubic (hermite) interpolated table value at phase x
+static inline int32_t goom_lookup(const float *t, int bits, uint32_t x) {
+	const float *y = &t[x >> (32 - bits)];
+	float frac = (float)(x << bits) * (1.f / FULL_CYCLE);
+	float ym1 = y[-1];
+	float y0 = y[0];
+	float y1 = y[1];
+	float y2 = y[2];
+	float c1 = 0.5f * (y1 - ym1);
+	float c2 = ym1 - (2.5f * y0) + (2.f * y1) - (0.5f * y2);
+	float c3 = (0.5f * (y2 - ym1)) + (1.5f * (y0 - y1));
+	return (int32_t) (((((c3 * frac) + c2) * frac) + c1) * frac + y0);
+}
+
+DSP_INLINE void goom_table_krate_n(struct goom_state *s,	// state
+				   int32_t pitch,	// inlet q11.21
+				   const int32_t * freq,	// inlet q5.27
+				   const int32_t * phase,	// inlet q5.27
+				   int32_t duty,	// inlet 0..127
+				   int32_t slope,	// inlet 0..127
+				   int32_t * out,	// outlet q5.27
+				   size_t n	// block size
+    ) {
+
+	// do we need to change the wave shape?
+	if ((duty != s->shape.duty) || (slope != s->shape.slope)) {
+		goom_set_shape(&s->shape, duty, slope);
+		goom_wave_put(s->wave);
+		s->wave = NULL;
+	}
+	if (s->wave == NULL) {
+		s->wave = goom_wave_get(s);
+		if (s->wave == NULL) {
+			// the cache is full
+			goom_blep_krate_n(s, pitch, freq, phase, duty, slope, out, n);
+			return;
+		}
+		s->blep = 0.f;
+	}
+	const struct goom_wave *w = s->wave;
+
+	s->xstep = goom_pitch_step(pitch);
+
+	uint32_t x = s->x;
+	uint32_t step;
+	uint32_t pofs;
+	if (goom_fixed_step(s->xstep, freq, phase, n, &step, &pofs)) {
+		// no modulation (or constant modulation)
+		int bits = GOOM_TABLE_BITS - goom_level(step);
+		const float *t = w->level[GOOM_TABLE_BITS - bits];
+		for (size_t i = 0; i < n; i++) {
+			out[i] = goom_lookup(t, bits, x + pofs);
+			x += step;
+		}
+	} else {
+		// per sample fm/pm, the mip level is set by the unmodulated pitch
+		int bits = GOOM_TABLE_BITS - goom_level(s->xstep);
+		const float *t = w->level[GOOM_TABLE_BITS - bits];
+		for (size_t i = 0; i < n; i++) {
+			out[i] = goom_lookup(t, bits, x + ((uint32_t) phase[i] << 4));
+			x += s->xstep + freq[i];
+		}
+	}
+	s->x = x;
+
+}
+
+static void goom_table_krate(struct goom_state *s, int32_t pitch, const int32_t * freq, const int32_t * phase, int32_t duty, int32_t slope, int32_t * out) {
+	goom_table_krate_n(s, pitch, freq, phase, duty, slope, out, BUFSIZE);
+}
+
+//-----------------------------------------------------------------------------
+// voice bank
+
+// Runs up to GOOM_VOICES goom voices in one call. The voice state is kept
+// contiguous (arrays indexed by voice) and the pitch to phase step conversion
+// is only done when a voice pitch changes. Each voice is generated with the
+// segmented runs, so the mix is accumulated voice by voice.
+
+#define GOOM_VOICES 16
+
+struct goom_poly_state {
+	int32_t pitch[GOOM_VOICES];	// pitch for xstep
+	uint32_t x[GOOM_VOICES];	// phase position
+	uint32_t xstep[GOOM_VOICES];	// phase step per sample
+	struct goom_shape shape[GOOM_VOICES];	// wave shape
+};
+
+static void goom_poly_init(struct goom_poly_state *s) {
+	memset(s, 0, sizeof(struct goom_poly_state));
+	goom_tables_init();
+	for (int v = 0; v < GOOM_VOICES; v++) {
+		// force an initial update
+		s->pitch[v] = INT32_MIN;
+		s->shape[v].duty = 0xff;
+	}
+}
+
+static void goom_poly_krate(struct goom_poly_state *s,	// state
+			    int n,	// number of voices
+			    const int32_t * pitch,	// inlets q11.21
+			    const int32_t * duty,	// inlets 0..127
+			    const int32_t * slope,	// inlets 0..127
+			    int32_t * mix,	// outlet q5.27 (sum of the voices)
+			    int32_t ** out	// outlets q5.27
+    ) {
+
+	// voice updates
+	for (int v = 0; v < n; v++) {
+		struct goom_shape *sh = &s->shape[v];
+		if ((duty[v] != sh->duty) || (slope[v] != sh->slope)) {
+			goom_set_shape(sh, duty[v], slope[v]);
+		}
+		if (pitch[v] != s->pitch[v]) {
+			s->pitch[v] = pitch[v];
+			s->xstep[v] = goom_pitch_step(pitch[v]);
+		}
+	}
+
+	memset(mix, 0, BUFSIZE * sizeof(int32_t));
+	for (int v = 0; v < n; v++) {
+		s->x[v] = goom_segments_n(&s->shape[v], s->x[v], s->xstep[v], out[v], BUFSIZE);
+		for (size_t i = 0; i < BUFSIZE; i++) {
+			mix[i] += out[v][i];
+		}
+	}
+	for (int v = n; v < GOOM_VOICES; v++) {
+		memset(out[v], 0, BUFSIZE * sizeof(int32_t));
 	}
 
 }
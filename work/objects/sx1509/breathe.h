@@ -0,0 +1,34 @@
+//-----------------------------------------------------------------------------
+/*
+
+SX1509 Driver: breathe
+  8 pin led driver
+
+Generated by sx1509_config.py, do not edit.
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef DEADSY_SX1509_BREATHE_H
+#define DEADSY_SX1509_BREATHE_H
+
+//-----------------------------------------------------------------------------
+
+static void sx1509_breathe_krate(struct sx1509_state *s, int32_t i4, int32_t i5, int32_t i6, int32_t i7, int32_t i12, int32_t i13, int32_t i14, int32_t i15) {
+	uint32_t dirty = 0;
+	dirty |= sx1509_led_intensity(s, 4, i4);
+	dirty |= sx1509_led_intensity(s, 5, i5);
+	dirty |= sx1509_led_intensity(s, 6, i6);
+	dirty |= sx1509_led_intensity(s, 7, i7);
+	dirty |= sx1509_led_intensity(s, 12, i12);
+	dirty |= sx1509_led_intensity(s, 13, i13);
+	dirty |= sx1509_led_intensity(s, 14, i14);
+	dirty |= sx1509_led_intensity(s, 15, i15);
+	sx1509_led_update(s, dirty);
+}
+
+//-----------------------------------------------------------------------------
+
+#endif				// DEADSY_SX1509_BREATHE_H
+
+//-----------------------------------------------------------------------------
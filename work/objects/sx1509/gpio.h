@@ -0,0 +1,51 @@
+//-----------------------------------------------------------------------------
+/*
+
+SX1509 Driver: gpio
+  8 gpio inputs, 8 gpio outputs
+
+Generated by sx1509_config.py, do not edit.
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef DEADSY_SX1509_GPIO_H
+#define DEADSY_SX1509_GPIO_H
+
+//-----------------------------------------------------------------------------
+
+#define SX1509_GPIO_GPIO_IN 0xff00
+#define SX1509_GPIO_GPIO_OUT 0x00ff
+
+static void sx1509_gpio_poll(struct sx1509_state *s) {
+	sx1509_gpio_read(s, SX1509_GPIO_GPIO_IN);
+	sx1509_gpio_write(s, SX1509_GPIO_GPIO_OUT, 0);
+}
+
+static void sx1509_gpio_krate(struct sx1509_state *s, int32_t out0, int32_t out1, int32_t out2, int32_t out3, int32_t out4, int32_t out5, int32_t out6, int32_t out7, int32_t * in8, int32_t * in9, int32_t * in10, int32_t * in11, int32_t * in12, int32_t * in13, int32_t * in14, int32_t * in15) {
+	uint16_t out = 0;
+	out |= (out0 != 0) << 0;
+	out |= (out1 != 0) << 1;
+	out |= (out2 != 0) << 2;
+	out |= (out3 != 0) << 3;
+	out |= (out4 != 0) << 4;
+	out |= (out5 != 0) << 5;
+	out |= (out6 != 0) << 6;
+	out |= (out7 != 0) << 7;
+	sx1509_gpio_set(s, out);
+	uint16_t in = s->gpio_in;
+	*in8 = (in >> 8) & 1;
+	*in9 = (in >> 9) & 1;
+	*in10 = (in >> 10) & 1;
+	*in11 = (in >> 11) & 1;
+	*in12 = (in >> 12) & 1;
+	*in13 = (in >> 13) & 1;
+	*in14 = (in >> 14) & 1;
+	*in15 = (in >> 15) & 1;
+}
+
+//-----------------------------------------------------------------------------
+
+#endif				// DEADSY_SX1509_GPIO_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,32 @@
+//-----------------------------------------------------------------------------
+/*
+
+SX1509 Driver: key
+  8x8 keyboard matrix scanner
+
+Generated by sx1509_config.py, do not edit.
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef DEADSY_SX1509_KEY_H
+#define DEADSY_SX1509_KEY_H
+
+//-----------------------------------------------------------------------------
+
+#define SX1509_KEY_ROWS 8
+#define SX1509_KEY_COL_MASK 0xff
+
+static void sx1509_key_poll(struct sx1509_state *s) {
+	sx1509_key_scan(s, SX1509_KEY_ROWS, SX1509_KEY_COL_MASK);
+}
+
+static void sx1509_key_krate(struct sx1509_state *s, int32_t * key, char **events) {
+	sx1509_key(s, key, events);
+}
+
+//-----------------------------------------------------------------------------
+
+#endif				// DEADSY_SX1509_KEY_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,32 @@
+//-----------------------------------------------------------------------------
+/*
+
+SX1509 Driver: key4x4
+  4x4 keyboard matrix scanner
+
+Generated by sx1509_config.py, do not edit.
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef DEADSY_SX1509_KEY4X4_H
+#define DEADSY_SX1509_KEY4X4_H
+
+//-----------------------------------------------------------------------------
+
+#define SX1509_KEY4X4_ROWS 4
+#define SX1509_KEY4X4_COL_MASK 0x0f
+
+static void sx1509_key4x4_poll(struct sx1509_state *s) {
+	sx1509_key_scan(s, SX1509_KEY4X4_ROWS, SX1509_KEY4X4_COL_MASK);
+}
+
+static void sx1509_key4x4_krate(struct sx1509_state *s, int32_t * key, char **events) {
+	sx1509_key(s, key, events);
+}
+
+//-----------------------------------------------------------------------------
+
+#endif				// DEADSY_SX1509_KEY4X4_H
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,26 @@
+//-----------------------------------------------------------------------------
+/*
+
+SX1509 Driver: keypad
+  8x8 keyboard matrix scanner
+  hardware keypad engine (4ms row scan)
+
+Generated by sx1509_config.py, do not edit.
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef DEADSY_SX1509_KEYPAD_H
+#define DEADSY_SX1509_KEYPAD_H
+
+//-----------------------------------------------------------------------------
+
+static void sx1509_keypad_krate(struct sx1509_state *s, int32_t * key, char **events) {
+	sx1509_key(s, key, events);
+}
+
+//-----------------------------------------------------------------------------
+
+#endif				// DEADSY_SX1509_KEYPAD_H
+
+//-----------------------------------------------------------------------------
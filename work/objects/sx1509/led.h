@@ -0,0 +1,42 @@
+//-----------------------------------------------------------------------------
+/*
+
+SX1509 Driver: led
+  16 pin led driver
+
+Generated by sx1509_config.py, do not edit.
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef DEADSY_SX1509_LED_H
+#define DEADSY_SX1509_LED_H
+
+//-----------------------------------------------------------------------------
+
+static void sx1509_led_krate(struct sx1509_state *s, int32_t i0, int32_t i1, int32_t i2, int32_t i3, int32_t i4, int32_t i5, int32_t i6, int32_t i7, int32_t i8, int32_t i9, int32_t i10, int32_t i11, int32_t i12, int32_t i13, int32_t i14, int32_t i15) {
+	uint32_t dirty = 0;
+	dirty |= sx1509_led_intensity(s, 0, i0);
+	dirty |= sx1509_led_intensity(s, 1, i1);
+	dirty |= sx1509_led_intensity(s, 2, i2);
+	dirty |= sx1509_led_intensity(s, 3, i3);
+	dirty |= sx1509_led_intensity(s, 4, i4);
+	dirty |= sx1509_led_intensity(s, 5, i5);
+	dirty |= sx1509_led_intensity(s, 6, i6);
+	dirty |= sx1509_led_intensity(s, 7, i7);
+	dirty |= sx1509_led_intensity(s, 8, i8);
+	dirty |= sx1509_led_intensity(s, 9, i9);
+	dirty |= sx1509_led_intensity(s, 10, i10);
+	dirty |= sx1509_led_intensity(s, 11, i11);
+	dirty |= sx1509_led_intensity(s, 12, i12);
+	dirty |= sx1509_led_intensity(s, 13, i13);
+	dirty |= sx1509_led_intensity(s, 14, i14);
+	dirty |= sx1509_led_intensity(s, 15, i15);
+	sx1509_led_update(s, dirty);
+}
+
+//-----------------------------------------------------------------------------
+
+#endif				// DEADSY_SX1509_LED_H
+
+//-----------------------------------------------------------------------------
@@ -14,6 +14,23 @@ Note:
 This allows multiple devices (each with a unique i2c address) to work concurrently.
 Tested with I2C1, SCL=PB8, SDA=PB9 (these are the config defaults)
 
+2) The keypad engine mode can use the NINT output of the chip. Connect it to
+a GPIO pin and select the pin with the nint attribute. The sx1509 thread then
+sleeps until the EXT interrupt on the pin wakes it, so the i2c bus is idle
+until a key is pressed. This needs HAL_USE_EXT (see patches/master/110-ext.patch).
+Without it (or with nint = none) the key data is polled. The EXT driver has one
+interrupt line per pin number, so each device needs a different pin number.
+
+3) The objects and their <name>.h headers are generated by sx1509_config.py.
+The generated header has the polling and k-rate functions for the object, with
+the key matrix size and the gpio banks as constants.
+
+4) LED driver: the k-rate code writes the pin intensities (I_ON) to a shadow of
+the LED registers and marks the changed pins as dirty. The sx1509 thread writes
+the dirty pins, a run of adjacent pins being a single auto-increment burst.
+Blink and breathe timing (T_ON, OFF, T_RISE, T_FALL) is set up by the object
+configuration and run by the chip.
+
 */
 //-----------------------------------------------------------------------------
 
@@ -22,10 +39,20 @@ Tested with I2C1, SCL=PB8, SDA=PB9 (these are the config defaults)
 
 //-----------------------------------------------------------------------------
 
+#include "sx1509_events.h"
+
+//-----------------------------------------------------------------------------
+
 #if CH_KERNEL_MAJOR == 2
 #define THD_WORKING_AREA_SIZE THD_WA_SIZE
 #define MSG_OK RDY_OK
 #define THD_FUNCTION(tname, arg) msg_t tname(void *arg)
+#define chVTGetSystemTimeX chTimeNow
+#define chThdGetSelfX chThdSelf
+#define chSysLockFromISR chSysLockFromIsr
+#define chSysUnlockFromISR chSysUnlockFromIsr
+#define TIME_MS2I MS2ST
+#define thread_t Thread
 #endif
 
 //-----------------------------------------------------------------------------
@@ -156,11 +183,17 @@ Tested with I2C1, SCL=PB8, SDA=PB9 (these are the config defaults)
 #define SX1509_MAX_COLS 8	// maximum key scan columns
 #define SX1509_DEBOUNCE_COUNT 2
 #define SX1509_KEY_POLL 4	// polling time in ms
+#define SX1509_KEYPAD_POLL 16	// keypad engine polling time in ms
 
-// key events
-#define SX1509_EVENT_NONE 0
-#define SX1509_EVENT_KEYDN 1
-#define SX1509_EVENT_KEYUP 2
+// driver modes (or-ed)
+#define SX1509_MODE_POLL (1 << 0)	// periodic polling (software key scan, gpio inputs)
+#define SX1509_MODE_KEYPAD (1 << 1)	// hardware keypad engine (KEY_CONFIG_1/2 set)
+#define SX1509_MODE_LED (1 << 2)	// LED driver
+
+#define SX1509_LED_SIZE (SX1509_T_FALL_15 - SX1509_T_ON_0 + 1)	// LED driver registers
+
+#define SX1509_NINT_EVENT EVENT_MASK(0)	// thread event: NINT asserted
+#define SX1509_DIRTY_EVENT EVENT_MASK(1)	// thread event: LED/gpio outputs are dirty
 
 //-----------------------------------------------------------------------------
 
@@ -170,28 +203,54 @@ struct sx1509_cfg {
 	uint8_t val;
 };
 
+// Key event queue: single producer (sx1509 thread), single consumer (dsp
+// thread). The producer only writes wr and the consumer only writes rd, so
+// no locking is needed.
+struct sx1509_queue {
+	volatile uint32_t wr;	// write count
+	volatile uint32_t rd;	// read count
+	uint32_t dropped;	// events dropped (queue full)
+	struct sx1509_event buf[SX1509_EVENT_QSIZE];
+};
+
+// LED driver register shadow (written by the dsp thread, read by the sx1509 thread)
+struct sx1509_led {
+	uint8_t reg[SX1509_LED_SIZE];	// T_ON_0 .. T_FALL_15
+	volatile uint32_t dirty;	// pins to be written
+};
+
 // sx1509 state variables
 struct sx1509_state {
 	stkalign_t thd_wa[THD_WORKING_AREA_SIZE(512) / sizeof(stkalign_t)];	// thread working area
-	Thread *thd;		// thread pointer
+	thread_t *thd;		// thread pointer
 	const struct sx1509_cfg *cfg;	// driver configuration
 	I2CDriver *dev;		// i2c bus driver
 	i2caddr_t adr;		// i2c device address
+	int mode;		// driver mode
+	void (*poll)(struct sx1509_state * s);	// polling function (generated)
+	ioportid_t nint_port;	// NINT gpio port (NULL for none)
+	int nint_pad;		// NINT gpio pin
 	uint8_t *tx;		// i2c tx buffer
 	uint8_t *rx;		// i2c rx buffer
 	uint64_t sample[SX1509_DEBOUNCE_COUNT];	// debounce buffer for key samples
 	uint64_t keys;		// current debounced key state
 	int idx;		// buffer index;
 	int row;		// current scan row;
-	uint32_t event;		// key event (shared across dsp/sx1509 threads)
+	uint8_t row_sel;	// key row select bits on bank A (sx1509 thread)
+	struct sx1509_queue queue;	// key events (shared across dsp/sx1509 threads)
+	struct sx1509_events events;	// key events for this k-rate tick
+	struct sx1509_led led;	// LED driver registers
+	volatile uint16_t gpio_in;	// gpio input bits (bank B:A)
+	volatile uint16_t gpio_out;	// gpio output bits (bank B:A)
+	volatile uint32_t gpio_dirty;	// gpio outputs to be written
 };
 
 //-----------------------------------------------------------------------------
 
 // Allocate a 32-bit aligned buffer of size bytes from sram2.
-// The memory pool is big enough for 4 concurrent devices.
+// The memory pool is big enough for 4 concurrent devices (2 of them LED drivers).
 static void *sx1509_malloc(size_t size) {
-	static uint8_t pool[32] __attribute__ ((section(".sram2")));
+	static uint8_t pool[(4 * 8) + (2 * (SX1509_LED_SIZE + 4))] __attribute__ ((section(".sram2")));
 	static uint32_t free = 0;
 	void *ptr = NULL;
 	// round up to 32-bit alignment
@@ -238,6 +297,16 @@ static int sx1509_wr8(struct sx1509_state *s, uint8_t reg, uint8_t val) {
 	return (rc == MSG_OK) ? 0 : -1;
 }
 
+// write n bytes to consecutive registers (auto-increment)
+static int sx1509_wr(struct sx1509_state *s, uint8_t reg, const uint8_t * buf, size_t n) {
+	s->tx[0] = reg;
+	memcpy(&s->tx[1], buf, n);
+	i2cAcquireBus(s->dev);
+	msg_t rc = i2cMasterTransmitTimeout(s->dev, s->adr, s->tx, n + 1, NULL, 0, SX1509_I2C_TIMEOUT);
+	i2cReleaseBus(s->dev);
+	return (rc == MSG_OK) ? 0 : -1;
+}
+
 //-----------------------------------------------------------------------------
 
 // reset the device
@@ -249,21 +318,38 @@ static int sx1509_reset(struct sx1509_state *s) {
 }
 
 //-----------------------------------------------------------------------------
-// locked access to the shared event variable
-
-// get the key event
-static uint32_t sx1509_get_event(struct sx1509_state *s) {
-	chSysLock();
-	uint32_t event = s->event;
-	chSysUnlock();
-	return event;
+// key event queue
+
+// add an event to the queue (sx1509 thread)
+static void sx1509_put_event(struct sx1509_queue *q, uint32_t key) {
+	uint32_t wr = q->wr;
+	if (wr - q->rd == SX1509_EVENT_QSIZE) {
+		q->dropped++;
+		return;
+	}
+	struct sx1509_event *e = &q->buf[wr & (SX1509_EVENT_QSIZE - 1)];
+	e->time = chVTGetSystemTimeX();
+	e->key = key;
+	// the event is written before the write count is
+	__sync_synchronize();
+	q->wr = wr + 1;
 }
 
-// set the key event
-static void sx1509_set_event(struct sx1509_state *s, uint32_t event) {
-	chSysLock();
-	s->event = event;
-	chSysUnlock();
+// read all the queued events (dsp thread)
+static void sx1509_get_events(struct sx1509_queue *q, struct sx1509_events *events) {
+	uint32_t rd = q->rd;
+	uint32_t wr = q->wr;
+	// the write count is read before the events are
+	__sync_synchronize();
+	int n = 0;
+	while (rd != wr) {
+		events->event[n++] = q->buf[rd & (SX1509_EVENT_QSIZE - 1)];
+		rd++;
+	}
+	events->n = n;
+	// the events are read before the slots are released
+	__sync_synchronize();
+	q->rd = rd;
 }
 
 //-----------------------------------------------------------------------------
@@ -287,35 +373,39 @@ static int sx1509_getkey(uint64_t * val) {
 static void sx1509_key_event(struct sx1509_state *s, uint64_t bits, int event) {
 	int key;
 	while ((key = sx1509_getkey(&bits)) >= 0) {
-		// wait for the dsp thread to read the key event
-		while (sx1509_get_event(s)) ;
-		// pass the new key event
-		sx1509_set_event(s, (event << 16) | key);
+		sx1509_put_event(&s->queue, (event << 16) | key);
 	}
 }
 
-// poll and debounce the key matrix
-static void sx1509_key_polling(struct sx1509_state *s) {
+// generate the key events for a change in key state
+static void sx1509_key_change(struct sx1509_state *s, uint64_t keys) {
+	if (keys != s->keys) {
+		sx1509_key_event(s, keys & ~s->keys, SX1509_EVENT_KEYDN);
+		sx1509_key_event(s, ~keys & s->keys, SX1509_EVENT_KEYUP);
+		s->keys = keys;
+	}
+}
+
+// Poll and debounce a rows x cols key matrix, one row per call. Rows are on
+// bank A (0..rows-1), columns are on bank B (8..8+cols-1). The generated
+// polling functions call this with constant rows/col_mask.
+static inline void sx1509_key_scan(struct sx1509_state *s, const int rows, const uint8_t col_mask) {
+	const uint8_t row_mask = (1 << rows) - 1;
 	// read the column bits
 	uint8_t col;
 	sx1509_rd8(s, SX1509_DATA_B, &col);
 	// add it to the sample buffer
 	s->sample[s->idx] &= ~(0xffULL << (s->row << 3));
-	s->sample[s->idx] |= (uint64_t) (col ^ 0xff) << (s->row << 3);
+	s->sample[s->idx] |= (uint64_t) (~col & col_mask) << (s->row << 3);
 	// work out the current key state
 	uint64_t keys = 0;
 	for (size_t i = 0; i < SX1509_DEBOUNCE_COUNT; i++) {
 		keys |= s->sample[i];
 	}
-	// has it changed?
-	if (keys != s->keys) {
-		sx1509_key_event(s, keys & ~s->keys, SX1509_EVENT_KEYDN);
-		sx1509_key_event(s, ~keys & s->keys, SX1509_EVENT_KEYUP);
-		s->keys = keys;
-	}
+	sx1509_key_change(s, keys);
 	// increment/wrap the row index
 	s->row++;
-	if (s->row == SX1509_MAX_ROWS) {
+	if (s->row == rows) {
 		// back to the 0th row
 		s->row = 0;
 		// increment/wrap the debounce buffer index
@@ -324,8 +414,217 @@ static void sx1509_key_polling(struct sx1509_state *s) {
 			s->idx = 0;
 		}
 	}
-	// write the row selection bits
-	sx1509_wr8(s, SX1509_DATA_A, ~(1 << s->row));
+	// write the row selection bits (keeping any gpio outputs on bank A)
+	s->row_sel = ~(1 << s->row) & row_mask;
+	sx1509_wr8(s, SX1509_DATA_A, s->row_sel | (s->gpio_out & ~row_mask & 0xff));
+}
+
+// Poll the keypad engine. The chip scans and debounces the matrix itself, so
+// this is a single read of the key data registers. The engine reports one key
+// at a time: a second key held with the first is not seen until the first is
+// released.
+static void sx1509_keypad_polling(struct sx1509_state *s) {
+	uint16_t val;
+	if (sx1509_rd16(s, SX1509_KEY_DATA_1, &val) < 0) {
+		return;
+	}
+	// KEY_DATA_1 (column) is the low byte, KEY_DATA_2 (row) is the high byte.
+	// The pressed key has its row and column bits cleared.
+	uint32_t col = ~val & 0xff;
+	uint32_t row = (~val >> 8) & 0xff;
+	uint64_t keys = 0;
+	if (col && row) {
+		keys = 1ULL << ((__builtin_ctz(row) << 3) + __builtin_ctz(col));
+	}
+	sx1509_key_change(s, keys);
+}
+
+//-----------------------------------------------------------------------------
+// gpio
+
+// read the gpio inputs (sx1509 thread)
+static inline void sx1509_gpio_read(struct sx1509_state *s, const uint16_t mask) {
+	if ((mask & 0xff00) && (mask & 0xff)) {
+		// DATA_B, DATA_A
+		uint16_t val;
+		sx1509_rd16(s, SX1509_DATA_B, &val);
+		s->gpio_in = ((val << 8) | (val >> 8)) & mask;
+	} else if (mask & 0xff00) {
+		uint8_t val;
+		sx1509_rd8(s, SX1509_DATA_B, &val);
+		s->gpio_in = (val << 8) & mask;
+	} else {
+		uint8_t val;
+		sx1509_rd8(s, SX1509_DATA_A, &val);
+		s->gpio_in = val & mask;
+	}
+}
+
+// Write the gpio outputs if they have changed (sx1509 thread). Key rows on
+// bank A (row_mask) keep their current row select bits.
+static inline void sx1509_gpio_write(struct sx1509_state *s, const uint16_t mask, const uint8_t row_mask) {
+	if (__sync_fetch_and_and(&s->gpio_dirty, 0) == 0) {
+		return;
+	}
+	uint16_t out = s->gpio_out;
+	uint8_t out_a = (out & ~row_mask & 0xff) | (s->row_sel & row_mask);
+	if ((mask & 0xff00) && (mask & 0xff)) {
+		// DATA_B, DATA_A
+		const uint8_t buf[2] = { out >> 8, out_a };
+		sx1509_wr(s, SX1509_DATA_B, buf, 2);
+	} else if (mask & 0xff00) {
+		sx1509_wr8(s, SX1509_DATA_B, out >> 8);
+	} else {
+		sx1509_wr8(s, SX1509_DATA_A, out_a);
+	}
+}
+
+// set the gpio outputs, wake the sx1509 thread if they have changed (dsp thread)
+static void sx1509_gpio_set(struct sx1509_state *s, uint16_t out) {
+	if (out == s->gpio_out) {
+		return;
+	}
+	s->gpio_out = out;
+	if (__sync_fetch_and_or(&s->gpio_dirty, 1) == 0) {
+		chEvtSignal(s->thd, SX1509_DIRTY_EVENT);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// LED driver
+
+// offset of the first register for each pin (T_ON_n - T_ON_0)
+// pins 4..7 and 12..15 have T_RISE/T_FALL (breathing) registers
+static const uint8_t sx1509_led_ofs[17] = {
+	0x00, 0x03, 0x06, 0x09,	// pins 0..3
+	0x0c, 0x11, 0x16, 0x1b,	// pins 4..7
+	0x20, 0x23, 0x26, 0x29,	// pins 8..11
+	0x2c, 0x31, 0x36, 0x3b,	// pins 12..15
+	SX1509_LED_SIZE,
+};
+
+// initialise the LED register shadow from the reset values and the configuration
+static void sx1509_led_init(struct sx1509_state *s) {
+	struct sx1509_led *led = &s->led;
+	for (int i = 0; i < 16; i++) {
+		led->reg[sx1509_led_ofs[i] + 1] = 0xff;	// I_ON
+	}
+	for (int i = 0; s->cfg[i].reg != 0xff; i++) {
+		uint8_t reg = s->cfg[i].reg;
+		if (reg >= SX1509_T_ON_0 && reg <= SX1509_T_FALL_15) {
+			led->reg[reg - SX1509_T_ON_0] = s->cfg[i].val;
+		}
+	}
+}
+
+// write the dirty pins (sx1509 thread)
+static void sx1509_led_flush(struct sx1509_state *s) {
+	struct sx1509_led *led = &s->led;
+	uint32_t dirty = __sync_fetch_and_and(&led->dirty, 0);
+	while (dirty) {
+		// write a run of adjacent dirty pins in one burst
+		int a = __builtin_ctz(dirty);
+		int n = __builtin_ctz(~(dirty >> a));
+		int ofs = sx1509_led_ofs[a];
+		sx1509_wr(s, SX1509_T_ON_0 + ofs, &led->reg[ofs], sx1509_led_ofs[a + n] - ofs);
+		dirty &= ~(((1U << n) - 1) << a);
+	}
+}
+
+// set the intensity of a pin from a frac32 (0..64), return the dirty bit (dsp thread)
+static inline uint32_t sx1509_led_intensity(struct sx1509_state *s, int pin, int32_t x) {
+	uint8_t *i_on = &s->led.reg[sx1509_led_ofs[pin] + 1];
+	uint8_t val = (x <= 0) ? 0 : ((x >= (1 << 27)) ? 0xff : (x >> 19));
+	if (val == *i_on) {
+		return 0;
+	}
+	*i_on = val;
+	return 1U << pin;
+}
+
+// mark pins as dirty and wake the sx1509 thread (dsp thread)
+static void sx1509_led_update(struct sx1509_state *s, uint32_t dirty) {
+	if (dirty == 0) {
+		return;
+	}
+	if (__sync_fetch_and_or(&s->led.dirty, dirty) == 0) {
+		chEvtSignal(s->thd, SX1509_DIRTY_EVENT);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// NINT interrupt
+
+#if HAL_USE_EXT
+
+// Shared by all devices. The channels are enabled as each device starts.
+static EXTConfig sx1509_ext_cfg;
+static thread_t *sx1509_ext_thd[EXT_MAX_CHANNELS];
+
+static void sx1509_ext_callback(EXTDriver * extp, expchannel_t channel) {
+	(void)extp;
+	chSysLockFromISR();
+	if (sx1509_ext_thd[channel] != NULL) {
+		chEvtSignalI(sx1509_ext_thd[channel], SX1509_NINT_EVENT);
+	}
+	chSysUnlockFromISR();
+}
+
+// enable the NINT interrupt for this thread, return 0 if ok
+static int sx1509_ext_start(struct sx1509_state *s) {
+	int ch = s->nint_pad;
+	if (s->nint_port == NULL || sx1509_ext_thd[ch] != NULL) {
+		return -1;
+	}
+	// NINT is open drain and active low
+	palSetPadMode(s->nint_port, ch, PAL_MODE_INPUT_PULLUP);
+	EXTChannelConfig cfg;
+	cfg.mode = EXT_CH_MODE_FALLING_EDGE | ((((uint32_t) s->nint_port - (uint32_t) GPIOA) / 0x400) << EXT_MODE_GPIO_OFF);
+	cfg.cb = sx1509_ext_callback;
+	chSysLock();
+	if (EXTD1.state != EXT_ACTIVE) {
+		chSysUnlock();
+		extStart(&EXTD1, &sx1509_ext_cfg);
+		chSysLock();
+	}
+	sx1509_ext_thd[ch] = chThdGetSelfX();
+	extSetChannelModeI(&EXTD1, ch, &cfg);
+	extChannelEnableI(&EXTD1, ch);
+	chSysUnlock();
+	return 0;
+}
+
+static void sx1509_ext_stop(struct sx1509_state *s) {
+	int ch = s->nint_pad;
+	chSysLock();
+	if (sx1509_ext_thd[ch] == chThdGetSelfX()) {
+		extChannelDisableI(&EXTD1, ch);
+		sx1509_ext_thd[ch] = NULL;
+	}
+	chSysUnlock();
+}
+
+#else
+
+static int sx1509_ext_start(struct sx1509_state *s) {
+	return -1;
+}
+
+static void sx1509_ext_stop(struct sx1509_state *s) {
+}
+
+#endif
+
+// Return the time to wait for the next thread event. The keypad engine with
+// NINT only polls the key data while a key is held (to see the release).
+static systime_t sx1509_timeout(struct sx1509_state *s, int nint) {
+	if (s->mode & SX1509_MODE_POLL) {
+		return TIME_MS2I(SX1509_KEY_POLL);
+	}
+	if ((s->mode & SX1509_MODE_KEYPAD) && (!nint || s->keys)) {
+		return TIME_MS2I(SX1509_KEYPAD_POLL);
+	}
+	return TIME_INFINITE;
 }
 
 //-----------------------------------------------------------------------------
@@ -334,6 +633,15 @@ static void sx1509_info(struct sx1509_state *s, const char *msg) {
 	LogTextMessage("sx1509(0x%x) %s", s->adr, msg);
 }
 
+// report any key events dropped since the last report
+static void sx1509_dropped(struct sx1509_state *s, uint32_t * reported) {
+	uint32_t dropped = s->queue.dropped;
+	if (dropped != *reported) {
+		LogTextMessage("sx1509(0x%x) %u key events dropped", s->adr, dropped - *reported);
+		*reported = dropped;
+	}
+}
+
 static void sx1509_error(struct sx1509_state *s, const char *msg) {
 	sx1509_info(s, msg);
 	// wait for the parent thread to kill us
@@ -348,11 +656,12 @@ static THD_FUNCTION(sx1509_thread, arg) {
 	struct sx1509_state *s = (struct sx1509_state *)arg;
 	int rc = 0;
 	int idx = 0;
+	uint32_t dropped = 0;
 
 	//sx1509_info(s, "starting thread");
 
 	// allocate i2c buffers
-	s->tx = (uint8_t *) sx1509_malloc(2);
+	s->tx = (uint8_t *) sx1509_malloc((s->mode & SX1509_MODE_LED) ? SX1509_LED_SIZE + 1 : 3);
 	s->rx = (uint8_t *) sx1509_malloc(2);
 	if (s->rx == NULL || s->tx == NULL) {
 		sx1509_error(s, "out of memory");
@@ -378,9 +687,31 @@ static THD_FUNCTION(sx1509_thread, arg) {
 		idx += 1;
 	}
 
+	int nint = (s->mode & SX1509_MODE_KEYPAD) && (sx1509_ext_start(s) == 0);
+
+	// The loop polls before it waits. NINT is edge triggered, so an interrupt
+	// left asserted from before sx1509_ext_start is read and cleared here.
 	while (!chThdShouldTerminate()) {
-		sx1509_key_polling(s);
-		chThdSleepMilliseconds(SX1509_KEY_POLL);
+		if (s->poll != NULL) {
+			s->poll(s);
+		}
+		if (s->mode & SX1509_MODE_KEYPAD) {
+			if (nint) {
+				// clear the column interrupts (releases NINT) before the key
+				// data is read, so a later key press asserts NINT again
+				sx1509_wr8(s, SX1509_INTERRUPT_SOURCE_B, 0xff);
+			}
+			sx1509_keypad_polling(s);
+		}
+		if (s->mode & SX1509_MODE_LED) {
+			sx1509_led_flush(s);
+		}
+		sx1509_dropped(s, &dropped);
+		chEvtWaitAnyTimeout(ALL_EVENTS, sx1509_timeout(s, nint));
+	}
+
+	if (nint) {
+		sx1509_ext_stop(s);
 	}
 
  exit:
@@ -390,30 +721,37 @@ static THD_FUNCTION(sx1509_thread, arg) {
 
 //-----------------------------------------------------------------------------
 
-static void sx1509_init(struct sx1509_state *s, const struct sx1509_cfg *cfg, i2caddr_t adr) {
+static void sx1509_init(struct sx1509_state *s, const struct sx1509_cfg *cfg, i2caddr_t adr, int mode, void (*poll)(struct sx1509_state * s), ioportid_t nint_port, int nint_pad) {
 	// initialise the state
 	memset(s, 0, sizeof(struct sx1509_state));
 	s->cfg = cfg;
 	s->dev = &I2CD1;
 	s->adr = adr;
+	s->mode = mode;
+	s->poll = poll;
+	s->nint_port = nint_port;
+	s->nint_pad = nint_pad;
+	s->row_sel = 0xff;	// no row selected (as per the DATA_A configuration)
+	sx1509_led_init(s);
 	// create the polling thread
 	s->thd = chThdCreateStatic(s->thd_wa, sizeof(s->thd_wa), NORMALPRIO, sx1509_thread, (void *)s);
 }
 
 static void sx1509_dispose(struct sx1509_state *s) {
-	// stop thread
+	// stop thread (wake it if it is waiting for an event)
 	chThdTerminate(s->thd);
+	chEvtSignal(s->thd, SX1509_NINT_EVENT);
 	chThdWait(s->thd);
 }
 
 // krate key function (the same for all object variants)
-static void sx1509_key(struct sx1509_state *s, int32_t * key) {
-	uint32_t event = sx1509_get_event(s);
-	if (event) {
-		// clear the event
-		sx1509_set_event(s, 0);
-	}
-	*key = event;
+// All the queued events are passed on the events outlet, the key outlet has
+// the last event (or 0 for none).
+static void sx1509_key(struct sx1509_state *s, int32_t * key, char **events) {
+	struct sx1509_events *e = &s->events;
+	sx1509_get_events(&s->queue, e);
+	*key = (e->n) ? e->event[e->n - 1].key : SX1509_EVENT_NONE;
+	*events = (char *)e;
 }
 
 //-----------------------------------------------------------------------------
@@ -4,6 +4,9 @@
 
 Generate custom objects for the SX1509 gpio/pwm/key chip
 
+Each object <name>.axo gets a <name>.h header with its polling and krate
+functions. The key matrix size and the gpio banks are constants in these.
+
 """
 #------------------------------------------------------------------------------
 
@@ -15,6 +18,33 @@ _base_driver = 'sx1509.h'
 _num_io_pins = 16
 _device_adr = (0x3e, 0x3f, 0x70, 0x71)
 
+# LED driver pins with breathing (T_RISE/T_FALL)
+_breathe_pins = (4, 5, 6, 7, 12, 13, 14, 15)
+
+# LED clock (2 MHz internal oscillator, MISC divider = 1)
+_led_clk = 2000000.0
+
+# NINT interrupt pins (menu entry, C entry)
+_nint_pins = (
+  ('none', 'NULL,0'),
+  ('PA0', 'GPIOA,0'),
+  ('PA1', 'GPIOA,1'),
+  ('PA2', 'GPIOA,2'),
+  ('PA3', 'GPIOA,3'),
+  ('PA4', 'GPIOA,4'),
+  ('PA5', 'GPIOA,5'),
+  ('PA6', 'GPIOA,6'),
+  ('PA7', 'GPIOA,7'),
+  ('PB0', 'GPIOB,0'),
+  ('PB1', 'GPIOB,1'),
+  ('PC0', 'GPIOC,0'),
+  ('PC1', 'GPIOC,1'),
+  ('PC2', 'GPIOC,2'),
+  ('PC3', 'GPIOC,3'),
+  ('PC4', 'GPIOC,4'),
+  ('PC5', 'GPIOC,5'),
+)
+
 #------------------------------------------------------------------------------
 
 def pr_error(msg, cond):
@@ -29,19 +59,30 @@ def wr_file(fname, data):
   f.write(data)
   f.close()
 
+def led_time(ms, lo, hi):
+  """return the 5 bit register value for an LED driver time"""
+  # 1..15: lo * val * 255 / clk, 16..31: hi * val * 255 / clk
+  times = [0.0,]
+  times.extend([1000.0 * lo * x * 255.0 / _led_clk for x in range(1, 16)])
+  times.extend([1000.0 * hi * x * 255.0 / _led_clk for x in range(16, 32)])
+  err = [abs(t - ms) for t in times]
+  return err.index(min(err))
+
 #------------------------------------------------------------------------------
 
 def gen_tag(tag, content=None, attrib=None):
   """generate a <tag attribute>content</tag> string"""
-  if attrib is None and content is None:
+  if attrib is None and not content:
     return '<%s/>' % tag
   elif attrib is None:
     return '<%s>%s</%s>' % (tag, content, tag)
-  elif content is None:
+  elif not content:
     return '<%s %s/>' % (tag, attrib)
   return '<%s %s>%s</%s>' % (tag, attrib, content, tag)
 
 def indent(s):
+  if not s:
+    return s
   items = s.split('\n')
   items.insert(0, '')
   items.append('')
@@ -53,13 +94,20 @@ class sx1509(object):
 
   def __init__(self, name, uuid):
     self.name = name
+    self.cname = 'sx1509_%s' % name # c prefix for the generated code
     self.uuid = uuid
     self.keys = False
+    self.keypad = False
     self.rows = 0
     self.cols = 0
     self.row_bits = 0
     self.col_bits = 0
     self.debounce = '4ms'
+    self.scan = '8ms'
+    self.sleep = 'off'
+    self.leds = {}
+    self.gpio_in = {}
+    self.gpio_out = []
     self.cfg = []
     self.alloc = [None,] * _num_io_pins
 
@@ -98,6 +146,59 @@ class sx1509(object):
       good = self.set_usage(8 + i, 'key col %d' % i)
       pr_error('col pin already used: %d' % i, not good)
 
+  def led(self, pin, mode='pwm', t_on=0, t_off=0, t_rise=0, t_fall=0):
+    """use a pin as an LED driver (pwm, blink or breathe), times in ms"""
+    pr_error('bad led mode: %s' % mode, mode not in ('pwm', 'blink', 'breathe'))
+    pr_error('pin %d can not breathe' % pin, mode == 'breathe' and pin not in _breathe_pins)
+    good = self.set_usage(pin, 'led %s' % mode)
+    pr_error('led pin already used: %d' % pin, not good)
+    if mode == 'pwm':
+      t_on = t_off = t_rise = t_fall = 0
+    elif mode == 'blink':
+      t_rise = t_fall = 0
+    self.leds[pin] = (mode, t_on, t_off, t_rise, t_fall)
+
+  def gpio(self, pin, direction, pullup=False):
+    """use a pin as a gpio input ('in') or output ('out')"""
+    pr_error('bad gpio direction: %s' % direction, direction not in ('in', 'out'))
+    good = self.set_usage(pin, 'gpio %s' % direction)
+    pr_error('gpio pin already used: %d' % pin, not good)
+    if direction == 'in':
+      self.gpio_in[pin] = pullup
+    else:
+      self.gpio_out.append(pin)
+
+  def pin_bits(self, pins, bank):
+    """return the bits for pins in bank A (pins 0..7) or B (pins 8..15)"""
+    ofs = (0, 8)[bank == 'B']
+    val = 0
+    for pin in pins:
+      if pin - ofs in range(8):
+        val |= 1 << (pin - ofs)
+    return val
+
+  def gpio_in_mask(self):
+    """return the 16 bit mask of the gpio inputs"""
+    return sum([1 << pin for pin in self.gpio_in])
+
+  def gpio_out_mask(self):
+    """return the 16 bit mask of the gpio outputs"""
+    return sum([1 << pin for pin in self.gpio_out])
+
+  def led_bits(self, bank):
+    """return the led pin bits for bank A (pins 0..7) or B (pins 8..15)"""
+    return self.pin_bits(self.leds, bank)
+
+  def keypad_engine(self, scan, sleep):
+    """use the hardware keypad engine for key scanning"""
+    pr_error('keypad engine needs key scanning', not self.keys)
+    pr_error('keypad engine needs 2 or more rows', self.rows < 2)
+    ms = lambda x: float(x[:-2]) if x.endswith('ms') else 1000.0 * float(x[:-1])
+    pr_error('scan time must be >= debounce time', ms(scan) < ms(self.debounce))
+    self.keypad = True
+    self.scan = scan
+    self.sleep = sleep
+
   def wr(self, name, default, val):
     if val != default:
       self.cfg.append(('SX1509_%s' % name, val))
@@ -118,11 +219,18 @@ class sx1509(object):
     val = (1 << 4)
     self.wr('MISC', 0, val)
 
+  def INPUT_DISABLE(self, bank):
+    # leds have the input buffer disabled
+    self.wr('INPUT_DISABLE_%s' % bank, 0, self.led_bits(bank))
+
   def DIR_A(self):
     val = 0xff # default inputs
     if self.keys:
       # rows are outputs on bank A (0..rows-1)
       val &= ~self.row_bits
+    # leds and gpio outputs are outputs
+    val &= ~self.led_bits('A')
+    val &= ~self.pin_bits(self.gpio_out, 'A')
     self.wr('DIR_A', 0xff, val)
 
   def DIR_B(self):
@@ -130,20 +238,55 @@ class sx1509(object):
     if self.keys:
       # columns are inputs on bank B (8..8+cols-1)
       val |= self.col_bits
+    # leds and gpio outputs are outputs
+    val &= ~self.led_bits('B')
+    val &= ~self.pin_bits(self.gpio_out, 'B')
     self.wr('DIR_B', 0xff, val)
 
+  def DATA(self, bank):
+    # leds are driven low (the led driver needs the data bit cleared)
+    # gpio outputs start low
+    val = 0xff & ~self.led_bits(bank) & ~self.pin_bits(self.gpio_out, bank)
+    self.wr('DATA_%s' % bank, 0xff, val)
+
   def OPEN_DRAIN_A(self):
     val = 0 # default off
     if self.keys:
       # rows are open drain
       val |= self.row_bits
+    # leds are open drain (current sink)
+    val |= self.led_bits('A')
     self.wr('OPEN_DRAIN_A', 0, val)
 
+  def OPEN_DRAIN_B(self):
+    # leds are open drain (current sink)
+    self.wr('OPEN_DRAIN_B', 0, self.led_bits('B'))
+
+  def LED_DRIVER_ENABLE(self, bank):
+    self.wr('LED_DRIVER_ENABLE_%s' % bank, 0, self.led_bits(bank))
+
+  def LED_TIMING(self):
+    for pin in sorted(self.leds):
+      (mode, t_on, t_off, t_rise, t_fall) = self.leds[pin]
+      self.wr('T_ON_%d' % pin, 0, led_time(t_on, 64, 512))
+      self.wr('OFF_%d' % pin, 0, led_time(t_off, 64, 512) << 3)
+      if pin in _breathe_pins:
+        # fade times are for a full scale (I_ON = 255, I_OFF = 0) fade
+        self.wr('T_RISE_%d' % pin, 0, led_time(t_rise, 255, 16 * 255))
+        self.wr('T_FALL_%d' % pin, 0, led_time(t_fall, 255, 16 * 255))
+
+  def PULL_UP_A(self):
+    # gpio inputs with pull ups
+    pins = [pin for pin in self.gpio_in if self.gpio_in[pin]]
+    self.wr('PULL_UP_A', 0, self.pin_bits(pins, 'A'))
+
   def PULL_UP_B(self):
     val = 0 # default off
     if self.keys:
       # columns are pull ups
       val |= self.col_bits
+    # gpio inputs with pull ups
+    val |= self.pin_bits([pin for pin in self.gpio_in if self.gpio_in[pin]], 'B')
     self.wr('PULL_UP_B', 0, val)
 
   def DEBOUNCE_CONFIG(self, ms):
@@ -153,11 +296,27 @@ class sx1509(object):
 
   def DEBOUNCE_ENABLE_B(self):
     val = 0 # default off
-    if self.keys:
+    if self.keypad:
       # columns are debounced inputs
       val |= self.col_bits
     self.wr('DEBOUNCE_ENABLE_B', 0, val)
 
+  def INTERRUPT_MASK_B(self):
+    val = 0xff # default masked
+    if self.keypad:
+      # the keypad engine asserts NINT on column interrupts
+      val &= ~self.col_bits
+    self.wr('INTERRUPT_MASK_B', 0xff, val)
+
+  def SENSE_B(self):
+    val = 0 # default none
+    if self.keypad:
+      # falling edge on the columns
+      for i in range(self.cols):
+        val |= 2 << (2 * i)
+    self.wr('SENSE_HIGH_B', 0, val >> 8)
+    self.wr('SENSE_LOW_B', 0, val & 0xff)
+
   def KEY_CONFIG_1(self, sleep, scan):
     val = 0
     if self.keys:
@@ -184,18 +343,33 @@ class sx1509(object):
     self.CLOCK()
     self.MISC()
     # IO bank A
+    self.INPUT_DISABLE('A')
     self.DIR_A()
     self.OPEN_DRAIN_A()
+    self.PULL_UP_A()
+    self.LED_DRIVER_ENABLE('A')
+    self.DATA('A')
     # IO bank B
+    self.INPUT_DISABLE('B')
     self.DIR_B()
+    self.OPEN_DRAIN_B()
     self.PULL_UP_B()
-    # input debouncing
-    self.DEBOUNCE_CONFIG(self.debounce)
+    self.LED_DRIVER_ENABLE('B')
+    self.DATA('B')
+    # interrupts
+    self.INTERRUPT_MASK_B()
+    self.SENSE_B()
+    # input debouncing (keypad engine)
+    # note: the software key scan does its own debouncing
+    if self.keypad:
+      self.DEBOUNCE_CONFIG(self.debounce)
     self.DEBOUNCE_ENABLE_B()
-    # key configuration
-    # note: we are not using the hw based key scanning at this time 
-    #self.KEY_CONFIG_1('1s', '8ms')
-    #self.KEY_CONFIG_2()
+    # key configuration (hardware keypad engine)
+    if self.keypad:
+      self.KEY_CONFIG_1(self.sleep, self.scan)
+      self.KEY_CONFIG_2()
+    # led blink/breathe timing
+    self.LED_TIMING()
     # terminate the register value list
     self.eol()
     s = []
@@ -204,13 +378,48 @@ class sx1509(object):
     s.extend(['  {%s, 0x%02x},' % x for x in self.cfg])
     s.append('};')
     s.append('struct sx1509_state state;')
+    s.append('struct prof_state prof;')
     return '\n'.join(s)
 
+  def krate_args(self):
+    """return the (axo argument, c parameter) list for the krate function"""
+    args = []
+    if self.keys:
+      args.append(('&outlet_key', 'int32_t * key'))
+      args.append(('&outlet_events', 'char **events'))
+    for pin in sorted(self.leds):
+      args.append(('inlet_i%d' % pin, 'int32_t i%d' % pin))
+    for pin in sorted(self.gpio_out):
+      args.append(('inlet_out%d' % pin, 'int32_t out%d' % pin))
+    for pin in sorted(self.gpio_in):
+      args.append(('&outlet_in%d' % pin, 'int32_t * in%d' % pin))
+    return args
+
   def gen_krate(self):
     """generate the krate function call(s)"""
+    args = ['&state',] + [x[0] for x in self.krate_args()]
     s = []
-    if self.keys:
-      s.append('sx1509_key(&state, &outlet_key);')
+    s.append('prof_start(&prof);')
+    s.append('%s_krate(%s);' % (self.cname, ', '.join(args)))
+    s.append('prof_stop(&prof);')
+    return '\n'.join(s)
+
+  def gen_init(self):
+    """generate the init code"""
+    mode = []
+    if (self.keys and not self.keypad) or self.gpio_in:
+      mode.append('SX1509_MODE_POLL')
+    if self.keypad:
+      mode.append('SX1509_MODE_KEYPAD')
+    if self.leds:
+      mode.append('SX1509_MODE_LED')
+    # gpio outputs alone need no mode, the thread is woken when they change
+    mode = ' | '.join(mode) if mode else '0'
+    poll = ('NULL', '%s_poll' % self.cname)[self.has_poll()]
+    nint = ('NULL, 0', 'attr_nint')[self.keypad]
+    s = []
+    s.append('sx1509_init(&state, &config[0], attr_adr, %s, %s, %s);' % (mode, poll, nint))
+    s.append('prof_init(&prof, "attr_name");')
     return '\n'.join(s)
 
   def gen_description(self):
@@ -219,6 +428,12 @@ class sx1509(object):
     s.append('SX1509 Driver: %s' % self.name)
     if self.keys:
       s.append('  %dx%d keyboard matrix scanner' % (self.rows, self.cols))
+    if self.keypad:
+      s.append('  hardware keypad engine (%s row scan)' % self.scan)
+    if self.leds:
+      s.append('  %d pin led driver' % len(self.leds))
+    if self.gpio_in or self.gpio_out:
+      s.append('  %d gpio inputs, %d gpio outputs' % (len(self.gpio_in), len(self.gpio_out)))
     return '\n'.join(s)
 
   def gen_includes(self):
@@ -226,7 +441,8 @@ class sx1509(object):
     s = []
     # See: https://github.com/axoloti/axoloti/issues/378
     s.append(gen_tag('include', './%s' % _base_driver))
-    #s.append(gen_tag('include', './%s.h' % self.name))
+    s.append(gen_tag('include', './%s.h' % self.name))
+    s.append(gen_tag('include', '../dsp/prof.h'))
     return '\n'.join(s)
 
   def gen_attribs(self):
@@ -235,13 +451,32 @@ class sx1509(object):
     adrs = indent('\n'.join(adrs))
     m_entries = gen_tag('MenuEntries', adrs)
     c_entries = gen_tag('CEntries', adrs)
-    return gen_tag('combo', indent(m_entries + '\n' + c_entries), 'name="adr"')
+    attribs = [gen_tag('combo', indent(m_entries + '\n' + c_entries), 'name="adr"'),]
+    if self.keypad:
+      m_entries = indent('\n'.join([gen_tag('string', x[0]) for x in _nint_pins]))
+      c_entries = indent('\n'.join([gen_tag('string', x[1]) for x in _nint_pins]))
+      m_entries = gen_tag('MenuEntries', m_entries)
+      c_entries = gen_tag('CEntries', c_entries)
+      attribs.append(gen_tag('combo', indent(m_entries + '\n' + c_entries), 'name="nint"'))
+    return '\n'.join(attribs)
+
+  def gen_inlets(self):
+    """generate the driver inlets"""
+    inlets = []
+    for pin in sorted(self.leds):
+      inlets.append(gen_tag('frac32.positive', None, 'name="i%d" description="pin %d intensity (%s)"' % (pin, pin, self.leds[pin][0])))
+    for pin in sorted(self.gpio_out):
+      inlets.append(gen_tag('bool32', None, 'name="out%d" description="pin %d output"' % (pin, pin)))
+    return '\n'.join(inlets)
 
   def gen_outlets(self):
     """generate the driver outlets"""
     outlets = []
     if self.keys:
-      outlets.append(gen_tag('int32', None, 'name="key"'))
+      outlets.append(gen_tag('int32', None, 'name="key" description="last key event"'))
+      outlets.append(gen_tag('charptr32', None, 'name="events" description="all key events (struct sx1509_events)"'))
+    for pin in sorted(self.gpio_in):
+      outlets.append(gen_tag('bool32', None, 'name="in%d" description="pin %d input"' % (pin, pin)))
     return '\n'.join(outlets)
 
   def gen_depends(self):
@@ -254,7 +489,7 @@ class sx1509(object):
     s.append(gen_tag('sDescription', self.gen_description()))
     s.append(gen_tag('author', 'Jason Harris'))
     s.append(gen_tag('license', 'BSD'))
-    s.append(gen_tag('inlets'))
+    s.append(gen_tag('inlets', indent(self.gen_inlets())))
     s.append(gen_tag('outlets', indent(self.gen_outlets())))
     s.append(gen_tag('displays'))
     s.append(gen_tag('params'))
@@ -262,33 +497,108 @@ class sx1509(object):
     s.append(gen_tag('includes', indent(self.gen_includes())))
     s.append(gen_tag('depends', indent(self.gen_depends())))
     s.append(gen_tag('code.declaration', '<![CDATA[' + self.gen_declaration() + ']]>'))
-    s.append(gen_tag('code.init', '<![CDATA[' + 'sx1509_init(&state, &config[0], attr_adr);' + ']]>'))
+    s.append(gen_tag('code.init', '<![CDATA[' + self.gen_init() + ']]>'))
     s.append(gen_tag('code.dispose', '<![CDATA[' + 'sx1509_dispose(&state);' +  ']]>'))
     s.append(gen_tag('code.krate', '<![CDATA[' + self.gen_krate() + ']]>'))
     s = gen_tag('obj.normal', indent('\n'.join(s)), 'id="%s" uuid="%s"' % (self.name, self.uuid))
     s = gen_tag('objdefs', indent(s), 'appVersion="1.0.12"')
     return s + '\n'
 
+  def has_poll(self):
+    """does the object need a polling function?"""
+    return (self.keys and not self.keypad) or bool(self.gpio_in) or bool(self.gpio_out)
+
+  def gen_poll(self):
+    """generate the polling function (sx1509 thread)"""
+    s = []
+    name = self.cname.upper()
+    s.append('static void %s_poll(struct sx1509_state *s) {' % self.cname)
+    if self.keys and not self.keypad:
+      s.append('\tsx1509_key_scan(s, %s_ROWS, %s_COL_MASK);' % (name, name))
+    if self.gpio_in:
+      s.append('\tsx1509_gpio_read(s, %s_GPIO_IN);' % name)
+    if self.gpio_out:
+      row_mask = ('0', '%s_ROW_MASK' % name)[self.keys]
+      s.append('\tsx1509_gpio_write(s, %s_GPIO_OUT, %s);' % (name, row_mask))
+    s.append('}')
+    return s
+
+  def gen_krate_h(self):
+    """generate the krate function (dsp thread)"""
+    s = []
+    params = ['struct sx1509_state *s',] + [x[1] for x in self.krate_args()]
+    s.append('static void %s_krate(%s) {' % (self.cname, ', '.join(params)))
+    if self.keys:
+      s.append('\tsx1509_key(s, key, events);')
+    if self.leds:
+      s.append('\tuint32_t dirty = 0;')
+      for pin in sorted(self.leds):
+        s.append('\tdirty |= sx1509_led_intensity(s, %d, i%d);' % (pin, pin))
+      s.append('\tsx1509_led_update(s, dirty);')
+    if self.gpio_out:
+      s.append('\tuint16_t out = 0;')
+      for pin in sorted(self.gpio_out):
+        s.append('\tout |= (out%d != 0) << %d;' % (pin, pin))
+      s.append('\tsx1509_gpio_set(s, out);')
+    if self.gpio_in:
+      s.append('\tuint16_t in = s->gpio_in;')
+      for pin in sorted(self.gpio_in):
+        s.append('\t*in%d = (in >> %d) & 1;' % (pin, pin))
+    s.append('}')
+    return s
+
   def gen_h(self):
     """generate the object *.h file"""
-    # read the base driver code
-    # See: https://github.com/axoloti/axoloti/issues/378
-    f = open(_base_driver, 'r')
-    drv = f.read()
-    f.close()
-    s = [drv,]
-    # add the krate function(s)
-    defname = 'DEADSY_%s_H' % self.name.upper()
+    name = self.cname.upper()
+    s = []
+    s.append('//' + '-' * 77)
+    s.append('/*')
     s.append('')
-    s.append('#ifndef %s' % defname)
-    s.append('#define %s' % defname)
-    # TODO add krate functions based on config...
-    s.append('#endif // %s' % defname)
-    return '\n'.join(s)
+    s.append(self.gen_description())
+    s.append('')
+    s.append('Generated by %s, do not edit.' % sys.argv[0].split('/')[-1])
+    s.append('')
+    s.append('*/')
+    s.append('//' + '-' * 77)
+    s.append('')
+    s.append('#ifndef DEADSY_%s_H' % name)
+    s.append('#define DEADSY_%s_H' % name)
+    s.append('')
+    s.append('//' + '-' * 77)
+    s.append('')
+    if self.keys and not self.keypad:
+      s.append('#define %s_ROWS %d' % (name, self.rows))
+      s.append('#define %s_COL_MASK 0x%02x' % (name, self.col_bits))
+    if self.gpio_in:
+      s.append('#define %s_GPIO_IN 0x%04x' % (name, self.gpio_in_mask()))
+    if self.gpio_out:
+      s.append('#define %s_GPIO_OUT 0x%04x' % (name, self.gpio_out_mask()))
+      if self.keys:
+        # gpio writes to bank A keep the row select bits
+        s.append('#define %s_ROW_MASK 0x%02x' % (name, self.row_bits))
+    if s[-1] != '':
+      s.append('')
+    if self.has_poll():
+      s.extend(self.gen_poll())
+      s.append('')
+    s.extend(self.gen_krate_h())
+    s.append('')
+    s.append('//' + '-' * 77)
+    s.append('')
+    s.append('#endif\t\t\t\t// DEADSY_%s_H' % name)
+    s.append('')
+    s.append('//' + '-' * 77)
+    return '\n'.join(s) + '\n'
+
+  def check(self):
+    """check the configuration can be generated"""
+    pr_error('%s: no pins are used' % self.name, all([x is None for x in self.alloc]))
+    pr_error('%s: keypad engine needs key scanning' % self.name, self.keypad and not self.keys)
 
   def generate(self):
+    self.check()
     wr_file('%s.axo' % self.name, self.gen_axo())
-    #wr_file('%s.h' % self.name, self.gen_h())
+    wr_file('%s.h' % self.name, self.gen_h())
 
 #------------------------------------------------------------------------------
 
@@ -300,6 +610,37 @@ def main():
   x.key_scanning(8, 8, '4ms')
   x.generate()
 
+  # key scanner (4x4)
+  x = sx1509('key4x4', '6a2d8f41-3c9b-4e07-a5d2-81f0b7c3e964')
+  x.key_scanning(4, 4, '4ms')
+  x.generate()
+
+  # key scanner (8x8) using the keypad engine
+  x = sx1509('keypad', '3b0f3c8e-5a52-4d1c-9a3e-6f2d7c41b8a5')
+  x.key_scanning(8, 8, '4ms')
+  x.keypad_engine('4ms', 'off')
+  x.generate()
+
+  # led driver (16 pwm pins)
+  x = sx1509('led', '9e5b1c2a-0d74-4f8e-b6a3-2c8f41d7e053')
+  for i in range(16):
+    x.led(i)
+  x.generate()
+
+  # led driver (8 breathing pins, ~0.75s period)
+  x = sx1509('breathe', 'd41f6a83-7c2e-4b95-8e10-5a3b9c6f2e7d')
+  for i in _breathe_pins:
+    x.led(i, 'breathe', t_on=120, t_off=120, t_rise=250, t_fall=250)
+  x.generate()
+
+  # gpio (8 outputs, 8 inputs with pull ups)
+  x = sx1509('gpio', 'f3a7c2d9-81e4-4b6a-9c05-d2e8b4f1a736')
+  for i in range(8):
+    x.gpio(i, 'out')
+  for i in range(8, 16):
+    x.gpio(i, 'in', pullup=True)
+  x.generate()
+
 
 main()
 
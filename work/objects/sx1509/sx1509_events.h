@@ -0,0 +1,43 @@
+//-----------------------------------------------------------------------------
+/*
+
+SX1509 Key Events
+
+The key event types shared by the sx1509 driver (sx1509.h) and the objects
+that take its events outlet. This header has no driver dependencies, so the
+event consumers don't need to include the driver.
+
+*/
+//-----------------------------------------------------------------------------
+
+#ifndef DEADSY_SX1509_EVENTS_H
+#define DEADSY_SX1509_EVENTS_H
+
+//-----------------------------------------------------------------------------
+
+// key events
+#define SX1509_EVENT_NONE 0
+#define SX1509_EVENT_KEYDN 1
+#define SX1509_EVENT_KEYUP 2
+
+#define SX1509_EVENT_QSIZE 64	// key event queue size (power of 2)
+
+//-----------------------------------------------------------------------------
+
+// timestamped key event
+struct sx1509_event {
+	uint32_t time;		// system time (ticks)
+	uint32_t key;		// (event << 16) | key
+};
+
+// the key events read by the dsp thread in a k-rate tick (events outlet)
+struct sx1509_events {
+	int n;			// number of events
+	struct sx1509_event event[SX1509_EVENT_QSIZE];
+};
+
+//-----------------------------------------------------------------------------
+
+#endif				// DEADSY_SX1509_EVENTS_H
+
+//-----------------------------------------------------------------------------